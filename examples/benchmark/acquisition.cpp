@@ -0,0 +1,130 @@
+#include <cstdlib>
+#include <thread>
+
+#include "bench.hpp"
+
+using namespace Twpp;
+
+namespace Bench {
+
+namespace {
+
+static const UInt32 rows = 256;
+static const UInt32 columns = 5100;
+static const UInt32 bytesPerRow = columns * 3; // 8.5 inch at 600 dpi, RGB
+static const UInt32 bandRows = 64;
+
+// a wrong transfer would make the timings meaningless
+void expect(bool condition, const char* what){
+    if (!condition){
+        std::fprintf(stderr, "acquisition ring: %s\n", what);
+        std::exit(1);
+    }
+}
+
+// device thread writing pages straight into bands, until the ring is cancelled
+class Device {
+
+public:
+    Device(UInt32 maxBatchBuffers = 1) :
+        m_ring(4, bandRows * bytesPerRow, maxBatchBuffers),
+        m_thread([this](){
+            produce(m_ring);
+        }){}
+
+    ~Device(){
+        m_ring.cancel();
+        m_thread.join();
+    }
+
+    AcquisitionRing& ring() noexcept{
+        return m_ring;
+    }
+
+    static void produce(AcquisitionRing& ring){
+        while (ring.beginImage(bytesPerRow, columns, rows)){
+            for (UInt32 row = 0; row < rows; ){
+                auto band = ring.acquire();
+                if (!band){
+                    return;
+                }
+
+                auto count = std::min(rows - row, band->maxRows());
+                std::memset(band->data(), static_cast<int>(row), count * bytesPerRow);
+                row += count;
+                ring.commit(count, count * bytesPerRow, row == rows);
+            }
+        }
+    }
+
+private:
+    AcquisitionRing m_ring;
+    std::thread m_thread;
+
+};
+
+// transfers a single page in strips of `memRows` rows, as imageMemXferGet would
+void memXferPage(AcquisitionRing& ring, UInt32 memRows){
+    ImageMemXfer xfer(Compression::None, 0, 0, 0, 0, 0, 0, Memory(memRows * bytesPerRow));
+    UInt32 total = 0;
+    Result rc;
+    do {
+        rc = ring.memXfer(xfer);
+        expect(rc.returnCode() == ReturnCode::Success || rc.returnCode() == ReturnCode::XferDone, "memXfer failed");
+        expect(xfer.yOffset() == total, "memXfer skipped rows");
+        total += xfer.rows();
+    } while (rc.returnCode() != ReturnCode::XferDone);
+
+    expect(total == rows, "memXfer lost rows");
+}
+
+}
+
+void acquisitionBenchmarks(Runner& runner){
+    // strips smaller than a band, several calls per band
+    {
+        Device device;
+        runner.run("ring.memxfer.strip_16_rows", 20, [&](){
+            memXferPage(device.ring(), 16);
+        });
+    }
+
+    // strips spanning several bands, whichever the device has already produced
+    {
+        Device device;
+        runner.run("ring.memxfer.strip_200_rows", 20, [&](){
+            memXferPage(device.ring(), 200);
+        });
+    }
+
+    // BMP rows are stored bottom-up, every row is copied separately
+    {
+        Device device;
+        runner.run("ring.nativexfer.bottom_up", 20, [&](){
+            ImageNativeXfer xfer;
+            auto rc = device.ring().nativeXfer(xfer, nullptr, 0, true);
+            expect(rc.returnCode() == ReturnCode::XferDone, "nativeXfer failed");
+
+            auto view = xfer.imageView(0, rows, bytesPerRow, true);
+            expect(view.row(rows - 1)[0] == static_cast<char>(rows - bandRows), "nativeXfer misplaced rows");
+        });
+    }
+
+    // the application cancels after the first strip, the device thread is woken up and stops
+    runner.run("ring.cancel", 20, [](){
+        AcquisitionRing ring(4, bandRows * bytesPerRow);
+        std::thread device([&](){
+            Device::produce(ring);
+        });
+
+        ImageMemXfer xfer(Compression::None, 0, 0, 0, 0, 0, 0, Memory(16 * bytesPerRow));
+        expect(ring.memXfer(xfer).returnCode() == ReturnCode::Success, "memXfer failed");
+
+        ring.cancel();
+        device.join();
+        expect(ring.memXfer(xfer).returnCode() == ReturnCode::Cancel, "memXfer not cancelled");
+        ring.reset();
+    });
+}
+
+}
@@ -0,0 +1,104 @@
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// data source version, some of the measured classes are not part of the application one
+#if !defined(TWPP_IS_DS)
+#   define TWPP_IS_DS
+#endif
+
+#include "twpp.hpp"
+
+namespace Bench {
+
+/// Registers and runs benchmark cases.
+/// Each case prints a single CSV line, see printHeader.
+class Runner {
+
+public:
+    /// \param filter Substring of case names to run, all cases if null or empty.
+    /// \param samples Number of timed samples of each case, the median is reported.
+    explicit Runner(const char* filter, unsigned samples = 5) :
+        m_filter(filter ? filter : ""), m_samples(samples != 0 ? samples : 1){}
+
+    static void printHeader(){
+        std::printf("name,iterations,samples,ns_per_op,ns_min,ns_spread_pct,allocs_per_op,raw_allocs_per_op,locks_per_op\n");
+    }
+
+    /// Runs `fn` `iterations` times in each sample, unless filtered out.
+    /// Allocations and locks are counted using Twpp::MemoryTelemetry over all samples.
+    void run(const char* name, unsigned long iterations, const std::function<void()>& fn){
+        if (!m_filter.empty() && std::strstr(name, m_filter.c_str()) == nullptr){
+            return;
+        }
+
+        // warm up, e.g. handle pool and caches
+        fn();
+
+        Twpp::MemoryTelemetry::enable();
+        Twpp::MemoryTelemetry::reset();
+        auto poolHits = Twpp::HandlePool::stats().hits();
+
+        std::vector<double> nsPerOp;
+        nsPerOp.reserve(m_samples);
+        for (unsigned s = 0; s < m_samples; s++){
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned long i = 0; i < iterations; i++){
+                fn();
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+            nsPerOp.push_back(static_cast<double>(ns) / static_cast<double>(iterations));
+        }
+
+        auto stats = Twpp::MemoryTelemetry::snapshot();
+        Twpp::MemoryTelemetry::disable();
+        auto rawAllocs = stats.allocs() - (Twpp::HandlePool::stats().hits() - poolHits);
+
+        // median is robust against scheduler hiccups,
+        // spread is the distance of the slowest sample from the fastest one
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        auto median = nsPerOp[nsPerOp.size() / 2];
+        auto spread = nsPerOp.front() > 0.0 ? (nsPerOp.back() - nsPerOp.front()) * 100.0 / nsPerOp.front() : 0.0;
+
+        double ops = static_cast<double>(iterations) * m_samples;
+        std::printf("%s,%lu,%u,%.2f,%.2f,%.1f,%.2f,%.2f,%.2f\n", name, iterations, m_samples,
+                    median, nsPerOp.front(), spread,
+                    static_cast<double>(stats.allocs()) / ops,
+                    static_cast<double>(rawAllocs) / ops,
+                    static_cast<double>(stats.locks()) / ops);
+        std::fflush(stdout);
+    }
+
+private:
+    std::string m_filter;
+    unsigned m_samples;
+
+};
+
+/// Keeps the compiler from optimizing away the value.
+template<typename T>
+inline void keep(const T& value){
+    static volatile char sink;
+    sink = *reinterpret_cast<const volatile char*>(&value);
+    (void) sink;
+}
+
+void memoryBenchmarks(Runner& runner);
+void constraintBenchmarks(Runner& runner);
+void searchBenchmarks(Runner& runner);
+void capabilityBenchmarks(Runner& runner);
+void sessionBenchmarks(Runner& runner);
+void acquisitionBenchmarks(Runner& runner);
+
+}
+
+#endif // BENCH_HPP
@@ -0,0 +1,18 @@
+# console application, no Qt, no DSM and no data source required
+
+TARGET = twppbench
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+INCLUDEPATH += $$PWD/../../
+
+SOURCES += main.cpp \
+    memory.cpp \
+    capability.cpp \
+    constraints.cpp \
+    search.cpp \
+    sessions.cpp \
+    acquisition.cpp
+
+HEADERS += bench.hpp
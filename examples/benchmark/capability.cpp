@@ -0,0 +1,155 @@
+#include "bench.hpp"
+
+using namespace Twpp;
+
+namespace Bench {
+
+namespace {
+
+/// Sums leading bytes of items of any container, see Capability::visit.
+struct SumVisitor {
+    template<typename T>
+    static UInt32 bits(const T& val){
+        UInt32 ret = 0;
+        std::memcpy(&ret, &val, sizeof(T) < sizeof(ret) ? sizeof(T) : sizeof(ret));
+        return ret;
+    }
+
+    template<Type type, typename DataType>
+    void operator()(const ItemSpan<type, DataType>& items){
+        // local sum, items could alias the member
+        UInt32 local = 0;
+        for (const auto& val : items){
+            local += bits(val);
+        }
+
+        sum += local;
+    }
+
+    template<Type type, typename DataType>
+    void operator()(const Range<type, DataType>& range){
+        UInt32 local = 0;
+        for (auto val : range){
+            local += bits(val);
+        }
+
+        sum += local;
+    }
+
+    UInt32 sum = 0;
+};
+
+}
+
+void capabilityBenchmarks(Runner& runner){
+    static const UInt32 largeItems = 4096;
+
+    // creation of every container type
+    runner.run("cap.create.one_value", 200000, [](){
+        auto cap = Capability::createOneValue<CapType::XferCount>(-1);
+        keep(cap);
+    });
+
+    runner.run("cap.create.array", 200000, [](){
+        auto cap = Capability::createArray<CapType::SupportedCaps>(
+            {CapType::XferCount, CapType::IPixelType, CapType::IBitDepth, CapType::IXResolution, CapType::IYResolution});
+        keep(cap);
+    });
+
+    runner.run("cap.create.enumeration", 200000, [](){
+        auto cap = Capability::createEnumeration<CapType::IPixelType>(
+            {PixelType::BlackWhite, PixelType::Gray, PixelType::Rgb}, 2, 2);
+        keep(cap);
+    });
+
+    runner.run("cap.create.range", 200000, [](){
+        auto cap = Capability::createRange<CapType::IXResolution>(
+            Fix32(50), Fix32(1200), Fix32(1), Fix32(300), Fix32(300));
+        keep(cap);
+    });
+
+    // access to existing containers
+    auto oneValue = Capability::createOneValue<CapType::XferCount>(-1);
+    auto enumeration = Capability::createEnumeration<CapType::IPixelType>(
+        {PixelType::BlackWhite, PixelType::Gray, PixelType::Rgb}, 2, 2);
+    auto range = Capability::createRange<CapType::IXResolution>(
+        Fix32(50), Fix32(1200), Fix32(1), Fix32(300), Fix32(300));
+
+    runner.run("cap.data.one_value", 200000, [&](){
+        keep(*oneValue.data<CapType::XferCount>().begin());
+    });
+
+    runner.run("cap.data.range.size", 200000, [&](){
+        keep(range.data<CapType::IXResolution>().size());
+    });
+
+    runner.run("cap.current_item.one_value", 200000, [&](){
+        keep(oneValue.currentItem<CapType::XferCount>());
+    });
+
+    runner.run("cap.current_item.enumeration", 200000, [&](){
+        keep(enumeration.currentItem<CapType::IPixelType>());
+    });
+
+    runner.run("cap.current_item.range", 200000, [&](){
+        keep(range.currentItem<CapType::IXResolution>());
+    });
+
+    // iteration of large containers
+    auto largeEnum = Capability::createEnumeration<Type::UInt32>(CapType::IImageDataSet, largeItems);
+    {
+        auto enm = largeEnum.enumeration<Type::UInt32>();
+        for (UInt32 i = 0; i < largeItems; i++){
+            enm[i] = i;
+        }
+    }
+
+    auto largeRange = Capability::createRange<Type::UInt32>(CapType::IImageDataSet, 0, largeItems - 1, 1, 0, 0);
+
+    runner.run("cap.iterate.enumeration.4096", 2000, [&](){
+        UInt32 sum = 0;
+        for (auto val : largeEnum.data<Type::UInt32>()){
+            sum += val;
+        }
+
+        keep(sum);
+    });
+
+    runner.run("cap.iterate.range.4096", 2000, [&](){
+        UInt32 sum = 0;
+        for (auto val : largeRange.data<Type::UInt32>()){
+            sum += val;
+        }
+
+        keep(sum);
+    });
+
+    runner.run("cap.visit.enumeration.4096", 2000, [&](){
+        SumVisitor visitor;
+        largeEnum.visit(visitor);
+        keep(visitor.sum);
+    });
+
+    runner.run("cap.visit.range.4096", 2000, [&](){
+        SumVisitor visitor;
+        largeRange.visit(visitor);
+        keep(visitor.sum);
+    });
+
+    // application requesting many entries at once
+    runner.run("ext_image_info.create.32", 200000, [](){
+        ExtImageInfo info({
+            InfoId::BarCodeX, InfoId::BarCodeY, InfoId::BarCodeText, InfoId::BarCodeType,
+            InfoId::BarCodeCount, InfoId::BarCodeConfidence, InfoId::BarCodeRotation, InfoId::BarCodeTextLength,
+            InfoId::DeShadeCount, InfoId::DeShadeTop, InfoId::DeShadeLeft, InfoId::DeShadeHeight,
+            InfoId::DeShadeWidth, InfoId::DeShadeSize, InfoId::SpecklesRemoved, InfoId::HorzLineXCoord,
+            InfoId::HorzLineYCoord, InfoId::HorzLineLength, InfoId::HorzLineThickness, InfoId::VertLineXCoord,
+            InfoId::VertLineYCoord, InfoId::VertLineLength, InfoId::VertLineThickness, InfoId::PatchCode,
+            InfoId::EndorsedText, InfoId::FormConfidence, InfoId::FormTemplateMatch, InfoId::FormTemplatePageMatch,
+            InfoId::FormHorzDocOffset, InfoId::FormVertDocOffset, InfoId::BookName, InfoId::ChapterNumber
+        });
+        keep(info);
+    });
+}
+
+}
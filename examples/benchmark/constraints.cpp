@@ -0,0 +1,64 @@
+#include "bench.hpp"
+
+using namespace Twpp;
+
+namespace Bench {
+
+void constraintBenchmarks(Runner& runner){
+    static const UInt16 caps = 256;
+    static const Int64 values = 16;
+
+    // every capability restricts the next one to its own value,
+    // changing the first one cascades through the chain,
+    // the last few capabilities form a separate short chain
+    auto custom = [](UInt16 i){
+        return static_cast<CapType>(static_cast<UInt16>(CapType::CustomBase) + i);
+    };
+
+    ConstraintEngine engine;
+    for (UInt16 i = 0; i < caps; i++){
+        engine.add(custom(i), Type::UInt32, 0, ValueSet::rawRange(0, values - 1, 1));
+    }
+
+    for (UInt16 i = 0; i + 1 < caps; i++){
+        if (i + 1 == caps - 4){
+            continue;
+        }
+
+        for (Int64 v = 0; v < values; v++){
+            engine.addRule(custom(i), v, custom(i + 1), ValueSet::rawRange(v, v, 1));
+        }
+    }
+
+    // re-evaluates the last few capabilities only
+    Int64 local = 0;
+    runner.run("constraint.set.local", 20000, [&](){
+        local = values - 1 - local;
+        engine.set(custom(caps - 4), local);
+        keep(engine.allowed(custom(caps - 1)));
+    });
+
+    engine.resetAll();
+
+    // changing the first capability adjusts every other one
+    Int64 cascade = 0;
+    runner.run("constraint.set.cascade", 2000, [&](){
+        cascade = values - 1 - cascade;
+        engine.set(custom(0), cascade);
+        keep(engine.allowed(custom(caps - 1)));
+    });
+
+    runner.run("constraint.allowed.cached", 20000, [&](){
+        for (UInt16 i = 0; i < caps; i += 16){
+            keep(engine.allowed(custom(i)));
+        }
+    });
+
+    // full re-evaluation of all capabilities and rules
+    runner.run("constraint.reset_all", 2000, [&](){
+        engine.resetAll();
+        keep(engine.allowed(custom(caps - 1)));
+    });
+}
+
+}
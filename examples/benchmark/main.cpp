@@ -0,0 +1,21 @@
+#include <cstdlib>
+
+#include "bench.hpp"
+
+// usage: twppbench [name filter] [samples]
+// telemetry adds a little overhead to every memory operation,
+// compare results only within a single build
+int main(int argc, char* argv[]){
+    Bench::Runner runner(argc > 1 ? argv[1] : nullptr,
+                         argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 5);
+
+    Bench::Runner::printHeader();
+    Bench::memoryBenchmarks(runner);
+    Bench::capabilityBenchmarks(runner);
+    Bench::constraintBenchmarks(runner);
+    Bench::searchBenchmarks(runner);
+    Bench::sessionBenchmarks(runner);
+    Bench::acquisitionBenchmarks(runner);
+
+    return 0;
+}
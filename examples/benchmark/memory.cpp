@@ -0,0 +1,101 @@
+#include "bench.hpp"
+
+using namespace Twpp;
+
+namespace Bench {
+
+void memoryBenchmarks(Runner& runner){
+    static const UInt32 rows = 64;
+    static const UInt32 bytesPerRow = 5100 * 3; // 8.5 inch at 600 dpi, RGB
+
+    Memory strip(rows * bytesPerRow);
+
+    // locks the handle for every row
+    runner.run("lock.strip.data_per_row", 2000, [&](){
+        for (UInt32 row = 0; row < rows; row++){
+            auto data = strip.data();
+            data[row * bytesPerRow] = static_cast<char>(row);
+        }
+    });
+
+    // copies of a single lock share it, one lock per strip
+    runner.run("lock.strip.shared_copies", 2000, [&](){
+        auto data = strip.data();
+        for (UInt32 row = 0; row < rows; row++){
+            auto copy = data;
+            copy[row * bytesPerRow] = static_cast<char>(row);
+        }
+    });
+
+    // row bands of a single view, as passed to worker threads
+    runner.run("lock.strip.image_view_bands", 2000, [&](){
+        auto view = strip.imageView(rows, bytesPerRow);
+        for (UInt32 row = 0; row < rows; row += 8){
+            auto band = view.band(row, 8);
+            band.row(0)[0] = static_cast<char>(row);
+        }
+    });
+
+    // raw round trips of memoryops.hpp, as done by every Lock instance
+    auto handle = Detail::alloc(64);
+    runner.run("memory.lock_unlock", 200000, [&](){
+        keep(Detail::lock(handle));
+        Detail::unlock(handle);
+    });
+    Detail::free(handle);
+
+    runner.run("memory.alloc_lock_free", 200000, [](){
+        auto h = Detail::alloc(64);
+        keep(Detail::lock(h));
+        Detail::unlock(h);
+        Detail::free(h);
+    });
+
+    runner.run("memory.lock_object", 200000, [&](){
+        auto data = strip.data();
+        keep(data.data());
+    });
+
+    // a strip is always filled, fresh pages of unpooled memory are faulted in while writing
+    auto fillStrip = [&](){
+        Memory mem(rows * bytesPerRow);
+        auto data = mem.data();
+        std::memset(data.data(), 0xFF, rows * bytesPerRow);
+        keep(mem);
+    };
+
+    runner.run("alloc.strip", 2000, fillStrip);
+
+    HandlePool::enable();
+    runner.run("alloc.strip.pooled", 2000, fillStrip);
+
+    runner.run("memory.alloc_lock_free.pooled", 200000, [](){
+        auto h = Detail::alloc(64);
+        keep(Detail::lock(h));
+        Detail::unlock(h);
+        Detail::free(h);
+    });
+    HandlePool::disable();
+
+    // a typical negotiation, every reply allocates a container
+    auto negotiate = [](){
+        for (int i = 0; i < 60; i++){
+            auto cap = Capability::createOneValue<CapType::XferCount>(-1);
+            auto enm = Capability::createEnumeration<CapType::IPixelType>(
+                {PixelType::BlackWhite, PixelType::Gray, PixelType::Rgb}, 2, 2);
+            keep(cap);
+            keep(enm);
+        }
+    };
+
+    runner.run("alloc.negotiation", 2000, negotiate);
+
+    runner.run("alloc.grow.1MiB", 200, [&](){
+        Memory mem;
+        for (UInt32 size = 4096; size <= 1024 * 1024; size += 4096){
+            mem.resize(size);
+        }
+    });
+}
+
+}
@@ -0,0 +1,76 @@
+#include "bench.hpp"
+
+using namespace Twpp;
+
+namespace Bench {
+
+void searchBenchmarks(Runner& runner){
+    static const UInt32 items = 256;
+
+    // e.g. barcode types or supported sizes, searching for the last item
+    auto enm = Capability::createEnumeration<Type::UInt16>(CapType::ISupportedBarCodeTypes, items);
+    auto enmData = enm.enumeration<Type::UInt16>();
+    for (UInt32 i = 0; i < items; i++){
+        enmData[i] = static_cast<UInt16>(i * 3);
+    }
+
+    const UInt16 needle = enmData[items - 1];
+
+    // the usual way of searching, CapIterator checks its kind on every step
+    runner.run("search.enum16.iterator", 200000, [&](){
+        UInt32 index = 0;
+        for (auto val : enm.data<Type::UInt16>()){
+            if (val == needle){
+                break;
+            }
+
+            index++;
+        }
+
+        keep(index);
+    });
+
+    runner.run("search.enum16.scalar", 200000, [&](){
+        keep(Detail::findItemScalar(&enmData[0], enmData.size(), needle));
+    });
+
+    runner.run("search.enum16.index_of", 200000, [&](){
+        keep(enmData.indexOf(needle));
+    });
+
+    auto bytes = Capability::createArray<Type::UInt8>(CapType::ICustHalfTone, items);
+    auto bytesData = bytes.array<Type::UInt8>();
+    for (UInt32 i = 0; i < items; i++){
+        bytesData[i] = static_cast<UInt8>(i);
+    }
+
+    runner.run("search.array8.scalar", 200000, [&](){
+        keep(Detail::findItemScalar(&bytesData[0], bytesData.size(), UInt8(255)));
+    });
+
+    runner.run("search.array8.index_of", 200000, [&](){
+        keep(bytesData.indexOf(UInt8(255)));
+    });
+
+    auto fix = Capability::createArray<Type::Fix32>(CapType::IXResolution, items);
+    auto fixData = fix.array<Type::Fix32>();
+    for (UInt32 i = 0; i < items; i++){
+        fixData[i] = Fix32(static_cast<Int16>(1200 - i * 4), static_cast<UInt16>(i * 255));
+    }
+
+    runner.run("search.array_fix32.minmax.scalar", 200000, [&](){
+        Fix32 min, max;
+        keep(Detail::minMaxItemsScalar(&fixData[0], fixData.size(), min, max));
+        keep(min);
+        keep(max);
+    });
+
+    runner.run("search.array_fix32.minmax", 200000, [&](){
+        Fix32 min, max;
+        keep(fixData.minMax(min, max));
+        keep(min);
+        keep(max);
+    });
+}
+
+}
@@ -0,0 +1,72 @@
+#include <list>
+
+#include "bench.hpp"
+
+using namespace Twpp;
+
+namespace Bench {
+
+namespace {
+
+// roughly the size of a small data source instance
+struct Session {
+    Identity m_appId;
+    char m_state[512];
+};
+
+}
+
+void sessionBenchmarks(Runner& runner){
+    static const UInt32 counts[] = {1, 16, 256, 4096};
+
+    char name[64];
+    for (auto count : counts){
+        // application IDs are assigned by DSM, usually consecutive
+        std::list<Session> list;
+        Detail::SessionTable<Session, Identity::Id> table;
+        for (UInt32 i = 0; i < count; i++){
+            list.emplace_back();
+            list.back().m_appId = Identity(i + 1, Version(), 2, 4, 0, "", "", "");
+
+            auto slot = table.emplace();
+            table.at(slot).m_appId = list.back().m_appId;
+            table.bind(slot, i + 1);
+        }
+
+        // every session in turn, the way a gateway with many applications dispatches triplets
+        UInt32 next = 0;
+        auto iterations = count > 256 ? 20000ul : 200000ul;
+
+        // the former SourceFromThis::find
+        std::snprintf(name, sizeof(name), "session.find.list.%u", count);
+        runner.run(name, iterations, [&](){
+            auto id = next++ % count + 1;
+            auto it = list.begin();
+            for ( ; it != list.end(); ++it){
+                if (it->m_appId.id() == id){
+                    break;
+                }
+            }
+
+            keep(it->m_state[0]);
+        });
+
+        next = 0;
+        std::snprintf(name, sizeof(name), "session.find.table.%u", count);
+        runner.run(name, iterations, [&](){
+            auto id = next++ % count + 1;
+            keep(table.at(table.find(id)).m_state[0]);
+        });
+
+        // OpenDs and CloseDs of one more application while the others stay open
+        std::snprintf(name, sizeof(name), "session.open_close.table.%u", count);
+        runner.run(name, 200000, [&](){
+            auto slot = table.emplace();
+            table.bind(slot, count + 1);
+            keep(table.find(count + 1));
+            table.erase(slot);
+        });
+    }
+}
+
+}
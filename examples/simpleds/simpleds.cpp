@@ -9,7 +9,6 @@
 #include "twglue.hpp"
 
 using namespace Twpp;
-using namespace std::placeholders;
 
 TWPP_ENTRY(SimpleDs)
 
@@ -30,6 +29,7 @@ static constexpr const Identity srcIdent(
 
 // lets just simulate uniform resolution for both axes
 static constexpr UInt32 RESOLUTION = 85;
+static constexpr UInt32 FEEDER_PAGES = 3;
 
 static int argc = 0;
 static char** argv = nullptr;
@@ -63,7 +63,7 @@ static Result oneValGet(Msg msg, Capability& data, const T& value){
         case Msg::Get:
         case Msg::GetCurrent:
         case Msg::GetDefault:
-            data = Capability::createOneValue(data.type(), value);
+            data.assignOneValue(value);
             return {};
 
         default:
@@ -75,11 +75,11 @@ template<typename T>
 static Result enmGet(Msg msg, Capability& data, const T& value){
     switch (msg){
         case Msg::Get:
-            data = Capability::createEnumeration(data.type(), {value});
+            data.assignEnumeration({value});
             return {};
         case Msg::GetCurrent:
         case Msg::GetDefault:
-            data = Capability::createOneValue(data.type(), value);
+            data.assignOneValue(value);
             return {};
 
         default:
@@ -95,11 +95,11 @@ static Result oneValGetSet(Msg msg, Capability& data, T& value, const T& def){
             // fallthrough
         case Msg::Get:
         case Msg::GetCurrent:
-            data = Capability::createOneValue(data.type(), value);
+            data.assignOneValue(value);
             return {};
 
         case Msg::GetDefault:
-            data = Capability::createOneValue(data.type(), def);
+            data.assignOneValue(def);
             return {};
 
         case Msg::Set:
@@ -118,7 +118,7 @@ static Result oneValGetSetConst(Msg msg, Capability& data, const T& def){
         case Msg::GetCurrent:
         case Msg::GetDefault:
         case Msg::Reset:
-            data = Capability::createOneValue(data.type(), def);
+            data.assignOneValue(def);
             return {};
 
         case Msg::Set:
@@ -135,13 +135,13 @@ template<typename T>
 static Result enmGetSetConst(Msg msg, Capability& data, const T& def){
     switch (msg){
         case Msg::Get:
-            data = Capability::createEnumeration(data.type(), {def});
+            data.assignEnumeration({def});
             return {};
 
         case Msg::GetCurrent:
         case Msg::GetDefault:
         case Msg::Reset:
-            data = Capability::createOneValue(data.type(), def);
+            data.assignOneValue(def);
             return {};
 
         case Msg::Set:
@@ -154,12 +154,7 @@ static Result enmGetSetConst(Msg msg, Capability& data, const T& def){
 }
 
 Result SimpleDs::capCommon(const Identity&, Msg msg, Capability& data){
-    auto it = m_caps.find(data.type());
-    if (it != m_caps.end()){
-        return (it->second)(msg, data);
-    }
-
-    return capUnsupported();
+    return m_caps.dispatch(*this, msg, data);
 }
 
 Result SimpleDs::capabilityGet(const Identity& origin, Capability& data){
@@ -174,26 +169,16 @@ Result SimpleDs::capabilityGetDefault(const Identity& origin, Capability& data){
     return capCommon(origin, Msg::GetDefault, data);
 }
 
-Result SimpleDs::capabilityQuerySupport(const Identity&, Capability& data){
-    auto it = m_query.find(data.type());
-    MsgSupport sup = it != m_query.end() ? it->second : msgSupportEmpty;
-    data = Capability::createOneValue(data.type(), sup);
-    return success();
+Result SimpleDs::capabilityQuerySupport(const Identity& origin, Capability& data){
+    return capCommon(origin, Msg::QuerySupport, data);
 }
 
 Result SimpleDs::capabilityReset(const Identity& origin, Capability& data){
     return capCommon(origin, Msg::Reset, data);
 }
 
-Result SimpleDs::capabilityResetAll(const Identity& origin){
-    for (auto& pair : m_query){
-        if ((pair.second & MsgSupport::Reset) != msgSupportEmpty){
-            Capability dummyCap(pair.first);
-            capCommon(origin, Msg::Reset, dummyCap);
-        }
-    }
-
-    return success();
+Result SimpleDs::capabilityResetAll(const Identity&){
+    return m_caps.resetAll(*this);
 }
 
 Result SimpleDs::capabilitySet(const Identity& origin, Capability& data){
@@ -224,105 +209,93 @@ Result SimpleDs::identityOpenDs(const Identity&){
 
     // init caps
     // there are caps a minimal source must support
-    // query -> says which operations a cap supports
-    // caps  -> has handler for each specific cap
-    m_query[CapType::SupportedCaps] = msgSupportGetAll;
-    m_caps[CapType::SupportedCaps] = [this](Msg msg, Capability& data){
-        switch (msg){
-            case Msg::Get:
-            case Msg::GetCurrent:
-            case Msg::GetDefault: {
-                data = Capability::createArray<CapType::SupportedCaps>(m_caps.size());
-                auto arr = data.array<CapType::SupportedCaps>();
-                UInt32 i = 0;
-                for (const auto& kv : m_caps){
-                    arr[i] = kv.first;
-                    i++;
-                }
+    // each cap has its supported operations and a handler,
+    // SupportedCaps and QuerySupport are handled by the registry
+    m_caps.clear();
 
-                return success();
-            }
+    m_caps.add(CapType::UiControllable, msgSupportGetAll, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGet(msg, data, Bool(true));
+    });
 
-            default:
-                return capBadOperation();
-        }
-    };
+    m_caps.add(CapType::DeviceOnline, msgSupportGetAll, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGet(msg, data, Bool(true));
+    });
 
-    m_query[CapType::UiControllable] = msgSupportGetAll;
-    m_caps[CapType::UiControllable] = std::bind(enmGet<Bool>, _1, _2, Bool(true));
-
-    m_query[CapType::DeviceOnline] = msgSupportGetAll;
-    m_caps[CapType::DeviceOnline] = std::bind(enmGet<Bool>, _1, _2, Bool(true));
-
-    m_query[CapType::XferCount] = msgSupportGetAllSetReset;
-    m_caps[CapType::XferCount] = [this](Msg msg, Capability& data) -> Result{
+    m_caps.add(CapType::XferCount, msgSupportGetAllSetReset, [](SimpleDs& self, Msg msg, Capability& data) -> Result{
         if (msg == Msg::Set){
             auto item = data.currentItem<Int16>();
-            if (item > 1 || item < -1){
+            if (item < -1){
                 return badValue();
             }
         }
 
-        auto ret = oneValGetSet<Int16>(msg, data, m_capXferCount, -1);
-        if (Twpp::success(ret) && m_capXferCount == 0){
-            m_capXferCount = -1;
+        auto ret = oneValGetSet<Int16>(msg, data, self.m_capXferCount, -1);
+        if (Twpp::success(ret) && self.m_capXferCount == 0){
+            self.m_capXferCount = -1;
             return {ReturnCode::CheckStatus, ConditionCode::BadValue};
         }
 
         return ret;
-    };
+    });
 
-    m_query[CapType::ICompression] = msgSupportGetAllSetReset;
-    m_caps[CapType::ICompression] = std::bind(enmGetSetConst<Compression>, _1, _2, Compression::None);
+    m_caps.add(CapType::ICompression, msgSupportGetAllSetReset, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, Compression::None);
+    });
 
+    m_caps.add(CapType::IBitDepth, msgSupportGetAllSetReset, [](SimpleDs& self, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, UInt16(self.header()->biBitCount));
+    });
 
-    m_query[CapType::IBitDepth] = msgSupportGetAllSetReset;
-    m_caps[CapType::IBitDepth] = std::bind(enmGetSetConst<UInt16>, _1, _2, UInt16(header()->biBitCount));
+    m_caps.add(CapType::IBitOrder, msgSupportGetAllSetReset, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, BitOrder::MsbFirst);
+    });
 
-    m_query[CapType::IBitOrder] = msgSupportGetAllSetReset;
-    m_caps[CapType::IBitOrder] = std::bind(enmGetSetConst<BitOrder>, _1, _2, BitOrder::MsbFirst);
+    m_caps.add(CapType::IPlanarChunky, msgSupportGetAllSetReset, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, PlanarChunky::Chunky);
+    });
 
-    m_query[CapType::IPlanarChunky] = msgSupportGetAllSetReset;
-    m_caps[CapType::IPlanarChunky] = std::bind(enmGetSetConst<PlanarChunky>, _1, _2, PlanarChunky::Chunky);
+    m_caps.add(CapType::IPhysicalWidth, msgSupportGetAll, [](SimpleDs& self, Msg msg, Capability& data){
+        return oneValGet(msg, data, Fix32(static_cast<float>(self.header()->biWidth) / RESOLUTION));
+    });
 
-    m_query[CapType::IPhysicalWidth] = msgSupportGetAll;
-    m_caps[CapType::IPhysicalWidth] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(static_cast<float>(header()->biWidth) / RESOLUTION));
+    m_caps.add(CapType::IPhysicalHeight, msgSupportGetAll, [](SimpleDs& self, Msg msg, Capability& data){
+        return oneValGet(msg, data, Fix32(static_cast<float>(self.header()->biHeight) / RESOLUTION));
+    });
 
-    m_query[CapType::IPhysicalHeight] = msgSupportGetAll;
-    m_caps[CapType::IPhysicalHeight] = std::bind(oneValGet<Fix32>, _1, _2, Fix32(static_cast<float>(header()->biHeight) / RESOLUTION));
+    m_caps.add(CapType::IPixelFlavor, msgSupportGetAllSetReset, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, PixelFlavor::Chocolate);
+    });
 
-    m_query[CapType::IPixelFlavor] = msgSupportGetAllSetReset;
-    m_caps[CapType::IPixelFlavor] = std::bind(enmGetSetConst<PixelFlavor>, _1, _2, PixelFlavor::Chocolate);
+    m_caps.add(CapType::IPixelType, msgSupportGetAllSetReset, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, PixelType::Rgb);
+    });
 
-    m_query[CapType::IPixelType] = msgSupportGetAllSetReset;
-    m_caps[CapType::IPixelType] = std::bind(enmGetSetConst<PixelType>, _1, _2, PixelType::Rgb);
+    m_caps.add(CapType::IUnits, msgSupportGetAllSetReset, [](SimpleDs&, Msg msg, Capability& data){
+        return enmGetSetConst(msg, data, Unit::Inches);
+    });
 
-    m_query[CapType::IUnits] = msgSupportGetAllSetReset;
-    m_caps[CapType::IUnits] = std::bind(enmGetSetConst<Unit>, _1, _2, Unit::Inches);
-
-    m_query[CapType::IXferMech] = msgSupportGetAllSetReset;
-    m_caps[CapType::IXferMech] = [this](Msg msg, Capability& data) -> Result{
+    m_caps.add(CapType::IXferMech, msgSupportGetAllSetReset, [](SimpleDs& self, Msg msg, Capability& data) -> Result{
         switch (msg){
             case Msg::Get:
-                data = Capability::createEnumeration<CapType::IXferMech>(
-                    {XferMech::Native, XferMech::Memory}, m_capXferMech == XferMech::Native ? 0 : 1, 0);
+                data.assignEnumeration<CapType::IXferMech>(
+                    {XferMech::Native, XferMech::Memory}, self.m_capXferMech == XferMech::Native ? 0 : 1, 0);
                 return success();
 
             case Msg::Reset:
-                m_capXferMech = XferMech::Native;
+                self.m_capXferMech = XferMech::Native;
                 // fallthrough
             case Msg::GetCurrent:
-                data = Capability::createOneValue<CapType::IXferMech>(m_capXferMech);
+                data.assignOneValue<CapType::IXferMech>(self.m_capXferMech);
                 return success();
 
             case Msg::GetDefault:
-                data = Capability::createOneValue<CapType::IXferMech>(XferMech::Native);
+                data.assignOneValue<CapType::IXferMech>(XferMech::Native);
                 return success();
 
             case Msg::Set: {
                 auto mech = data.currentItem<CapType::IXferMech>();
                 if (mech == XferMech::Native || mech == XferMech::Memory){
-                    m_capXferMech = mech;
+                    self.m_capXferMech = mech;
                     return success();
                 } else {
                     return badValue();
@@ -332,18 +305,17 @@ Result SimpleDs::identityOpenDs(const Identity&){
             default:
                 return capBadOperation();
         }
-    };
+    });
 
-    m_query[CapType::IXResolution] = msgSupportGetAllSetReset;
-    m_caps[CapType::IXResolution] = [](Msg msg, Capability& data){
+    auto resolution = [](SimpleDs&, Msg msg, Capability& data){
         switch (msg){
             case Msg::Get:
-                data = Capability::createEnumeration(data.type(), {Fix32(RESOLUTION)});
+                data.assignEnumeration({Fix32(RESOLUTION)});
                 return success();
             case Msg::GetCurrent:
             case Msg::GetDefault:
             case Msg::Reset:
-                data = Capability::createOneValue(data.type(), Fix32(RESOLUTION));
+                data.assignOneValue(Fix32(RESOLUTION));
                 return success();
 
             case Msg::Set:
@@ -355,14 +327,15 @@ Result SimpleDs::identityOpenDs(const Identity&){
         }
     };
 
-    m_query[CapType::IYResolution] = msgSupportGetAllSetReset;
-    m_caps[CapType::IYResolution] = m_caps[CapType::IXResolution];
+    m_caps.add(CapType::IXResolution, msgSupportGetAllSetReset, resolution);
+    m_caps.add(CapType::IYResolution, msgSupportGetAllSetReset, resolution);
 
-    m_query[CapType::IXNativeResolution] = msgSupportGetAll;
-    m_caps[CapType::IXNativeResolution] = std::bind(enmGet<Fix32>, _1, _2, Fix32(RESOLUTION));
+    auto nativeResolution = [](SimpleDs&, Msg msg, Capability& data){
+        return enmGet(msg, data, Fix32(RESOLUTION));
+    };
 
-    m_query[CapType::IYNativeResolution] = msgSupportGetAll;
-    m_caps[CapType::IYNativeResolution] = m_caps[CapType::IXNativeResolution];
+    m_caps.add(CapType::IXNativeResolution, msgSupportGetAll, nativeResolution);
+    m_caps.add(CapType::IYNativeResolution, msgSupportGetAll, nativeResolution);
 
     return success();
 }
@@ -374,18 +347,21 @@ Result SimpleDs::identityCloseDs(const Identity&){
 }
 
 Result SimpleDs::pendingXfersGet(const Identity&, PendingXfers& data){
-    data.setCount(m_pendingXfers);
-    return success();
+    return m_pages.get(data);
 }
 
 Result SimpleDs::pendingXfersEnd(const Identity&, PendingXfers& data){
-    data.setCount(0);
-    return success();
+    m_memXferPage = false;
+    return m_pages.end(data);
 }
 
 Result SimpleDs::pendingXfersReset(const Identity&, PendingXfers& data){
-    data.setCount(0);
-    return success();
+    m_memXferPage = false;
+    return m_pages.reset(data);
+}
+
+Result SimpleDs::pendingXfersStopFeeder(const Identity&, PendingXfers& data){
+    return m_pages.stopFeeder(data);
 }
 
 Result SimpleDs::setupMemXferGet(const Identity&, SetupMemXfer& data){
@@ -411,17 +387,30 @@ Result SimpleDs::userInterfaceDisable(const Identity&, UserInterface&){
 #endif
 
     application.reset();
+    m_pages.cancel();
+    m_memXferPage = false;
     return success();
 }
 
-Result SimpleDs::userInterfaceEnable(const Identity&, UserInterface& ui){
-    m_pendingXfers = 1;
-    m_memXferYOff = 0;
+void SimpleDs::startScan(){
+    // pretend there is a feeder with a few copies of our image, next page is "scanned" while the current one is transferred
+    m_memXferPage = false;
+    m_pages.start(m_capXferCount, [](UInt32 index, QByteArray& page, PendingXfers::JobPatch&){
+        if (index >= FEEDER_PAGES){
+            return false;
+        }
 
+        page = bmpData;
+        return true;
+    });
+}
+
+Result SimpleDs::userInterfaceEnable(const Identity&, UserInterface& ui){
     if (!ui.showUi()){
         // this is an exception when we want to set state explicitly, notifyXferReady can be called only in enabled state
         // with hidden UI, the usual workflow DsState::Enabled -> notifyXferReady() -> DsState::XferReady is a single step
         setState(DsState::Enabled);
+        startScan();
         auto notified = notifyXferReady();
         return Twpp::success(notified) ? success() : bummer();
     }
@@ -451,6 +440,7 @@ Result SimpleDs::userInterfaceEnable(const Identity&, UserInterface& ui){
 
     // the dialog does not need to know about TWPP, just give it simple functions to notify us
     auto scanFunction = [this](){
+        startScan();
         notifyXferReady();
     };
 
@@ -495,7 +485,7 @@ Result SimpleDs::imageLayoutGet(const Identity&, ImageLayout& data){
 
     data.setDocumentNumber(1);
     data.setFrameNumber(1);
-    data.setPageNumber(1);
+    data.setPageNumber(m_pages.transferred() + 1);
     data.setFrame(Frame(0, 0, static_cast<float>(dib->biWidth) / RESOLUTION, static_cast<float>(dib->biHeight) / RESOLUTION));
     return success();
 }
@@ -518,76 +508,54 @@ Result SimpleDs::imageLayoutReset(const Identity& origin, ImageLayout& data){
 }
 
 Result SimpleDs::imageMemXferGet(const Identity& origin, ImageMemXfer& data){
-    if (!m_pendingXfers){
+    auto page = m_pages.current();
+    if (!page){
         return seqError();
     }
 
+    if (!m_memXferPage){
+        // bottom-up BMP -> top-down memory transfer
+        auto dib = header();
+        auto bpl = bytesPerLine();
+        m_memXfer = MemXferWriter(bmpEnd(*page) - bpl, -static_cast<Int32>(bpl), bpl, static_cast<UInt32>(dib->biWidth),
+                                  static_cast<UInt32>(std::abs(dib->biHeight)), static_cast<UInt16>(dib->biBitCount));
+        m_memXferPage = true;
+    }
+
     // we can call our TWPP methods, but be careful about states
     SetupMemXfer setup;
     setupMemXferGet(origin, setup);
 
     // just a simple stored BMP image
-    auto dib = header();
-    auto bpl = bytesPerLine();
-    auto memSize = data.memory().size();
-    if (memSize > setup.maxSize() || memSize < setup.minSize()){
-        return badValue();
+    auto rc = m_memXfer.write(data, setup);
+    if (!Twpp::success(rc) && rc != ReturnCode::XferDone){
+        return rc;
     }
 
-    auto maxRows = memSize / bpl;
-    auto rows = std::min<UInt32>(maxRows, static_cast<UInt32>(dib->biHeight) - m_memXferYOff);
-    if (rows == 0){
-        return seqError(); // image already transfered in this session
-    }
-
-    data.setBytesPerRow(bpl);
-    data.setColumns(static_cast<UInt32>(dib->biWidth));
-    data.setRows(rows);
-    data.setBytesWritten(rows * bpl);
-    data.setXOffset(0);
-    data.setYOffset(m_memXferYOff);
-    data.setCompression(Compression::None);
-
-    auto lock = data.memory().data();
-    char* out = lock.data();
-
-    // bottom-up BMP -> top-down memory transfer
-    auto begin = bmpEnd() - (bpl * (m_memXferYOff + 1));
-    for (UInt32 i = 0; i < rows; i++){
-        // copy bytes
-        std::copy(begin, begin + bpl, out);
-
-        char* line = out;
-        out += bpl;
-        begin -= bpl;
-
-        // BGR BMP -> RGB memory transfer
-        for ( ; line + 3 < out; line += 3){
+    // BGR BMP -> RGB memory transfer
+    auto view = data.imageView();
+    for (UInt32 i = 0; i < view.rows(); i++){
+        char* line = view.row(i);
+        char* end = line + view.bytesPerRow();
+        for ( ; line + 3 < end; line += 3){
             std::swap(line[0], line[2]);
         }
     }
 
-    m_memXferYOff += rows;
-
-    if (m_memXferYOff >= static_cast<UInt32>(std::abs(dib->biHeight))){
-        m_pendingXfers = 0;
-        return {ReturnCode::XferDone, ConditionCode::Success};
-    }
-
-    return success();
+    return rc;
 }
 
 Result SimpleDs::imageNativeXferGet(const Identity&, ImageNativeXfer& data){
-    if (!m_pendingXfers){
+    auto page = m_pages.current();
+    if (!page){
         return seqError();
     }
 
     // it does not get easier than that if we already have BMP
     data = ImageNativeXfer(bmpSize());
 
-    std::copy(bmpBegin(), bmpEnd(), data.data<char>().data());
+    std::copy(bmpBegin(*page), bmpEnd(*page), data.data<char>().data());
 
-    m_pendingXfers = 0;
     return {ReturnCode::XferDone, ConditionCode::Success};
 }
 
@@ -604,12 +572,12 @@ UInt32 SimpleDs::bmpSize() const noexcept{
     return static_cast<UInt32>(bmpData.size()) - sizeof(BITMAPFILEHEADER);
 }
 
-const char* SimpleDs::bmpBegin() const noexcept{
-    return bmpData.cbegin() + sizeof(BITMAPFILEHEADER);
+const char* SimpleDs::bmpBegin(const QByteArray& page) const noexcept{
+    return page.cbegin() + sizeof(BITMAPFILEHEADER);
 }
 
-const char* SimpleDs::bmpEnd() const noexcept{
-    return bmpData.cend();
+const char* SimpleDs::bmpEnd(const QByteArray& page) const noexcept{
+    return page.cend();
 }
 
 #if TWPP_DETAIL_OS_WIN
@@ -1,19 +1,9 @@
 #ifndef SIMPLEDS_HPP
 #define SIMPLEDS_HPP
 
-#include <twpp.hpp>
-#include <unordered_map>
-
-namespace std {
+#include <QByteArray>
 
-template<>
-struct hash<Twpp::CapType> {
-    size_t operator()(Twpp::CapType cap) const{
-        return hash<Twpp::UInt16>()(static_cast<Twpp::UInt16>(cap));
-    }
-};
-
-}
+#include <twpp.hpp>
 
 class SimpleDs : public Twpp::SourceFromThis<SimpleDs> {
 
@@ -37,6 +27,7 @@ protected:
     virtual Twpp::Result pendingXfersGet(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
     virtual Twpp::Result pendingXfersEnd(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
     virtual Twpp::Result pendingXfersReset(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
+    virtual Twpp::Result pendingXfersStopFeeder(const Twpp::Identity& origin, Twpp::PendingXfers& data) override;
     virtual Twpp::Result setupMemXferGet(const Twpp::Identity& origin, Twpp::SetupMemXfer& data) override;
     virtual Twpp::Result userInterfaceDisable(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
     virtual Twpp::Result userInterfaceEnable(const Twpp::Identity& origin, Twpp::UserInterface& data) override;
@@ -55,16 +46,17 @@ private:
     const BITMAPINFOHEADER* header() const noexcept;
     Twpp::UInt32 bytesPerLine() const noexcept;
     Twpp::UInt32 bmpSize() const noexcept;
-    const char* bmpBegin() const noexcept;
-    const char* bmpEnd() const noexcept;
+    const char* bmpBegin(const QByteArray& page) const noexcept;
+    const char* bmpEnd(const QByteArray& page) const noexcept;
+    void startScan();
 
     Twpp::Result capCommon(const Twpp::Identity& origin, Twpp::Msg msg, Twpp::Capability& data);
 
-    std::unordered_map<Twpp::CapType, std::function<Twpp::Result(Twpp::Msg msg, Twpp::Capability& data)>> m_caps;
-    std::unordered_map<Twpp::CapType, Twpp::MsgSupport> m_query;
+    Twpp::CapabilityRegistry<SimpleDs> m_caps;
 
-    Twpp::UInt32 m_memXferYOff;
-    Twpp::UInt16 m_pendingXfers;
+    Twpp::PagePipeline<QByteArray> m_pages;
+    Twpp::MemXferWriter m_memXfer;
+    bool m_memXferPage = false;
 
     Twpp::Int16 m_capXferCount = -1;
     Twpp::XferMech m_capXferMech = Twpp::XferMech::Native;
@@ -44,10 +44,19 @@ SOFTWARE.
 #include <string>
 #include <list>
 #include <cstring>
+#include <cmath>
 #include <array>
 #include <utility>
 #include <cassert>
 #include <functional>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <exception>
+#include <chrono>
 
 #include "twpp/utils.hpp"
 
@@ -57,8 +66,11 @@ SOFTWARE.
 #include "twpp/frame.hpp"
 #include "twpp/exception.hpp"
 #include "twpp/typesops.hpp"
+#include "twpp/itemsearch.hpp"
+#include "twpp/sessiontable.hpp"
 
 #include "twpp/memoryops.hpp"
+#include "twpp/memoryview.hpp"
 #include "twpp/memory.hpp"
 
 #include "twpp/enums.hpp"
@@ -87,14 +99,22 @@ SOFTWARE.
 #include "twpp/pendingxfers.hpp"
 #include "twpp/setupfilexfer.hpp"
 #include "twpp/setupmemxfer.hpp"
+#include "twpp/tripletstats.hpp"
 #include "twpp/userinterface.hpp"
 
 #if !defined(TWPP_IS_DS)
 #   include "twpp/application.hpp"
+#   include "twpp/scanprofile.hpp"
 #else
 #   include "twpp/datasource.hpp"
+#   include "twpp/capabilityregistry.hpp"
+#   include "twpp/acquisitionring.hpp"
+#   include "twpp/memxferwriter.hpp"
+#   include "twpp/pagepipeline.hpp"
 #endif
 
+#include "twpp/constraints.hpp"
+
 
 #if !defined(TWPP_NO_NOTES)
 #   if !defined(TWPP_IS_DS)
@@ -0,0 +1,470 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#ifndef TWPP_DETAIL_FILE_ACQUISITIONRING_HPP
+#define TWPP_DETAIL_FILE_ACQUISITIONRING_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// Bounded ring of image bands passed from a device thread to transfer calls of a data source.
+/// The device thread (producer) writes rows straight into preallocated bands,
+/// transfer calls on the DSM thread (consumer) copy whole rows into application memory
+/// using a single bulk copy per call.
+///
+/// Producer: `beginImage`, then `acquire` and `commit` until the last band.
+/// Consumer: `memXfer` from `imageMemXferGet` or `imageMemFileXferGet`, `nativeXfer` from `imageNativeXferGet`.
+///
+/// Backpressure: the producer blocks when all bands are full,
+/// and in `beginImage` while `maxBatchBuffers` images are waiting for transfer,
+/// set it to the current value of CapType::MaxBatchBuffers.
+/// Exactly one producer and one consumer thread are supported.
+class AcquisitionRing {
+
+public:
+    /// Ring statistics.
+    class Stats {
+
+    public:
+        constexpr Stats() noexcept :
+            m_producerWaits(0), m_consumerWaits(0){}
+
+        constexpr Stats(UInt64 producerWaits, UInt64 consumerWaits) noexcept :
+            m_producerWaits(producerWaits), m_consumerWaits(consumerWaits){}
+
+        /// Number of times the producer waited for a free band or image slot.
+        constexpr UInt64 producerWaits() const noexcept{
+            return m_producerWaits;
+        }
+
+        /// Number of times a transfer call waited for the device.
+        constexpr UInt64 consumerWaits() const noexcept{
+            return m_consumerWaits;
+        }
+
+    private:
+        UInt64 m_producerWaits;
+        UInt64 m_consumerWaits;
+
+    };
+
+    /// Band of rows, owned by the producer between `acquire` and `commit`.
+    class Band {
+
+        friend class AcquisitionRing;
+
+    public:
+        /// Writable band data.
+        char* data() noexcept{
+            return m_data.get();
+        }
+
+        /// Size of the band data in bytes.
+        UInt32 capacity() const noexcept{
+            return m_capacity;
+        }
+
+        /// Number of whole rows of the current image fitting into this band.
+        UInt32 maxRows() const noexcept{
+            return m_bytesPerRow != 0 ? m_capacity / m_bytesPerRow : 0;
+        }
+
+    private:
+        std::unique_ptr<char[]> m_data;
+        UInt32 m_capacity = 0;
+        UInt32 m_bytes = 0;
+        UInt32 m_rows = 0;
+        bool m_last = false;
+
+        // image layout, copied from beginImage
+        Compression m_compression = Compression::None;
+        UInt32 m_bytesPerRow = 0;
+        UInt32 m_columns = 0;
+        UInt32 m_imageRows = 0;
+
+    };
+
+    /// Creates ring of preallocated bands.
+    /// \param bands Number of bands, at least 2 for the device and transfers to overlap.
+    /// \param bandSize Size of a single band in bytes, e.g. the preferred size of SetupMemXfer.
+    /// \param maxBatchBuffers Maximal number of images waiting for transfer.
+    /// \throw std::bad_alloc
+    AcquisitionRing(UInt32 bands, UInt32 bandSize, UInt32 maxBatchBuffers = 1) :
+        m_bands(bands), m_maxImages(maxBatchBuffers != 0 ? maxBatchBuffers : 1){
+
+        assert(bands > 0 && bandSize > 0);
+        for (auto& band : m_bands){
+            band.m_data.reset(new char[bandSize]);
+            band.m_capacity = bandSize;
+        }
+    }
+
+    AcquisitionRing(const AcquisitionRing&) = delete;
+    AcquisitionRing& operator=(const AcquisitionRing&) = delete;
+
+    /// Sets maximal number of images waiting for transfer, see CapType::MaxBatchBuffers.
+    void setMaxBatchBuffers(UInt32 maxBatchBuffers){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxImages = maxBatchBuffers != 0 ? maxBatchBuffers : 1;
+        m_notFull.notify_all();
+    }
+
+    // producer
+
+    /// Starts a new image, blocks while `maxBatchBuffers` images are waiting for transfer.
+    /// \param bytesPerRow Number of bytes of a single row, including padding.
+    /// \param columns Number of pixels of a single row.
+    /// \param rows Number of rows of the image, zero if unknown.
+    /// \param compression Compression of the data, compressed bands are transferred whole.
+    /// \return False if the ring was cancelled.
+    bool beginImage(UInt32 bytesPerRow, UInt32 columns, UInt32 rows, Compression compression = Compression::None){
+        assert(compression != Compression::None || bytesPerRow != 0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_images >= m_maxImages && !m_cancelled){
+            m_producerWaits++;
+            m_notFull.wait(lock, [this](){
+                return m_images < m_maxImages || m_cancelled;
+            });
+        }
+
+        if (m_cancelled){
+            return false;
+        }
+
+        m_images++;
+        m_compression = compression;
+        m_bytesPerRow = bytesPerRow;
+        m_columns = columns;
+        m_imageRows = rows;
+        return true;
+    }
+
+    /// Free band to write rows of the current image into, blocks while all bands are full.
+    /// \return Null if the ring was cancelled.
+    Band* acquire(){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_count == m_bands.size() && !m_cancelled){
+            m_producerWaits++;
+            m_notFull.wait(lock, [this](){
+                return m_count < m_bands.size() || m_cancelled;
+            });
+        }
+
+        if (m_cancelled){
+            return nullptr;
+        }
+
+        auto& band = m_bands[(m_head + m_count) % m_bands.size()];
+        band.m_compression = m_compression;
+        band.m_bytesPerRow = m_bytesPerRow;
+        band.m_columns = m_columns;
+        band.m_imageRows = m_imageRows;
+        return &band;
+    }
+
+    /// Passes the acquired band to transfer calls.
+    /// \param rows Number of rows written into the band.
+    /// \param bytes Number of bytes written, whole rows for uncompressed images.
+    /// \param last Whether this is the last band of the image.
+    void commit(UInt32 rows, UInt32 bytes, bool last){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cancelled){
+            return;
+        }
+
+        auto& band = m_bands[(m_head + m_count) % m_bands.size()];
+        assert(bytes <= band.m_capacity);
+        assert(band.m_compression != Compression::None || bytes == rows * band.m_bytesPerRow);
+        band.m_rows = rows;
+        band.m_bytes = bytes;
+        band.m_last = last;
+        m_count++;
+        m_notEmpty.notify_one();
+    }
+
+    /// Convenience: writes uncompressed rows of the current image, acquiring and committing bands as needed.
+    /// \param data First row.
+    /// \param rows Number of rows.
+    /// \param last Whether these are the last rows of the image.
+    /// \return False if the ring was cancelled.
+    bool write(const char* data, UInt32 rows, bool last){
+        do {
+            auto band = acquire();
+            if (!band){
+                return false;
+            }
+
+            auto bandRows = std::min(rows, band->maxRows());
+            assert(bandRows != 0);
+            auto bytes = bandRows * band->m_bytesPerRow;
+            std::memcpy(band->data(), data, bytes);
+
+            data += bytes;
+            rows -= bandRows;
+            commit(bandRows, bytes, last && rows == 0);
+        } while (rows != 0);
+
+        return true;
+    }
+
+    // consumer
+
+    /// Memory transfer, call from `imageMemXferGet` or `imageMemFileXferGet`.
+    /// Blocks until the device produces data.
+    /// Fills as many whole rows as fit into the application memory,
+    /// continues with following bands only if they are already available.
+    /// Compressed bands are transferred one per call.
+    /// \return XferDone after the last rows of the image, Cancel if the ring was cancelled,
+    ///         Failure with BadValue if the memory can not hold a single row or compressed band.
+    Result memXfer(Detail::ImageMemXferImpl& data){
+        auto band = front(true);
+        if (!band){
+            return {ReturnCode::Cancel, ConditionCode::Success};
+        }
+
+        auto& mem = data.memory();
+        auto available = band->m_bytes - m_readOffset;
+        bool compressed = band->m_compression != Compression::None;
+        if (compressed ? available > mem.size() : available != 0 && mem.size() < band->m_bytesPerRow){
+            return {ReturnCode::Failure, ConditionCode::BadValue};
+        }
+
+        data.setCompression(band->m_compression);
+        data.setBytesPerRow(band->m_bytesPerRow);
+        data.setColumns(band->m_columns);
+        data.setXOffset(0);
+        data.setYOffset(m_yOffset);
+
+        auto lock = mem.data();
+        UInt32 rows = 0;
+        UInt32 bytes = 0;
+        bool last = false;
+        do {
+            UInt32 bandRows;
+            UInt32 bandBytes;
+            available = band->m_bytes - m_readOffset;
+            if (!compressed){
+                bandRows = std::min(mem.size() - bytes, available) / band->m_bytesPerRow;
+                bandBytes = bandRows * band->m_bytesPerRow;
+            } else {
+                bandRows = band->m_rows;
+                bandBytes = available;
+            }
+
+            if (bandBytes != 0){
+                std::memcpy(lock.data() + bytes, band->m_data.get() + m_readOffset, bandBytes);
+            }
+
+            rows += bandRows;
+            bytes += bandBytes;
+            m_yOffset += bandRows;
+            m_readOffset += bandBytes;
+            if (m_readOffset < band->m_bytes){
+                break; // memory is full
+            }
+
+            // the band belongs to the producer again
+            last = pop();
+        } while (!last && !compressed && (band = front(false)) != nullptr);
+
+        data.setRows(rows);
+        data.setBytesWritten(bytes);
+        return last ? Result(ReturnCode::XferDone, ConditionCode::Success) : success();
+    }
+
+    /// Native transfer, call from `imageNativeXferGet`.
+    /// Blocks until the whole image is produced, bands are copied as they arrive.
+    /// \param header Native image header, e.g. BITMAPINFOHEADER and palette, copied before rows.
+    /// \param headerSize Size of the header in bytes.
+    /// \param bottomUp Whether to store uncompressed rows bottom-up, as in BMP. Requires known number of rows.
+    /// \return XferDone, Cancel if the ring was cancelled.
+    /// \throw std::bad_alloc
+    Result nativeXfer(ImageNativeXfer& data, const char* header = nullptr, UInt32 headerSize = 0, bool bottomUp = false){
+        auto band = front(true);
+        if (!band){
+            return {ReturnCode::Cancel, ConditionCode::Success};
+        }
+
+        if (band->m_compression != Compression::None || band->m_imageRows == 0){
+            // unknown size, collect everything first
+            std::vector<char> bytes(header, header + headerSize);
+            bool last;
+            do {
+                bytes.insert(bytes.end(), band->m_data.get(), band->m_data.get() + band->m_bytes);
+                last = pop();
+            } while (!last && (band = front(true)) != nullptr);
+
+            if (!last){
+                return {ReturnCode::Cancel, ConditionCode::Success};
+            }
+
+            data = ImageNativeXfer(static_cast<UInt32>(bytes.size()));
+            std::copy(bytes.cbegin(), bytes.cend(), data.data<char>().data());
+            return {ReturnCode::XferDone, ConditionCode::Success};
+        }
+
+        auto rows = band->m_imageRows;
+        auto bytesPerRow = band->m_bytesPerRow;
+        ImageNativeXfer xfer(headerSize + rows * bytesPerRow);
+        if (headerSize != 0){
+            std::memcpy(xfer.data<char>().data(), header, headerSize);
+        }
+
+        auto view = xfer.imageView(headerSize, rows, bytesPerRow, bottomUp);
+        bool last;
+        do {
+            auto bandRows = std::min(band->m_rows, rows - std::min(rows, m_yOffset));
+            if (!bottomUp){
+                std::memcpy(view.row(m_yOffset), band->m_data.get(), bandRows * bytesPerRow);
+            } else {
+                for (UInt32 i = 0; i < bandRows; i++){
+                    std::memcpy(view.row(m_yOffset + i), band->m_data.get() + i * bytesPerRow, bytesPerRow);
+                }
+            }
+
+            m_yOffset += bandRows;
+            last = pop();
+        } while (!last && (band = front(true)) != nullptr);
+
+        if (!last){
+            return {ReturnCode::Cancel, ConditionCode::Success};
+        }
+
+        data = std::move(xfer);
+        return {ReturnCode::XferDone, ConditionCode::Success};
+    }
+
+    /// Cancels the transfer, wakes both threads.
+    /// Subsequent producer and consumer calls fail until `reset`.
+    void cancel(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    /// Whether the ring was cancelled.
+    bool cancelled() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cancelled;
+    }
+
+    /// Drops all bands and images, e.g. on MSG_RESET of PendingXfers.
+    /// The producer must not be running.
+    void reset(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_head = 0;
+        m_count = 0;
+        m_images = 0;
+        m_readOffset = 0;
+        m_yOffset = 0;
+        m_cancelled = false;
+    }
+
+    /// Number of images that have been started but not yet transferred.
+    UInt32 pendingImages() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_images;
+    }
+
+    Stats stats() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return {m_producerWaits, m_consumerWaits};
+    }
+
+private:
+    static constexpr Result success() noexcept{
+        return {ReturnCode::Success, ConditionCode::Success};
+    }
+
+    /// The oldest band.
+    /// The band stays owned by the consumer until `pop`.
+    /// \param wait Whether to wait until there is one.
+    /// \return Null if the ring was cancelled, or is empty and not waiting.
+    Band* front(bool wait){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_count == 0 && !m_cancelled){
+            if (!wait){
+                return nullptr;
+            }
+
+            m_consumerWaits++;
+            m_notEmpty.wait(lock, [this](){
+                return m_count != 0 || m_cancelled;
+            });
+        }
+
+        return m_cancelled ? nullptr : &m_bands[m_head];
+    }
+
+    /// Releases the oldest band.
+    /// \return Whether it was the last band of the image.
+    bool pop(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool last = m_bands[m_head].m_last;
+        m_head = (m_head + 1) % m_bands.size();
+        m_count--;
+        m_readOffset = 0;
+        if (last){
+            m_yOffset = 0;
+            m_images--;
+        }
+
+        m_notFull.notify_all();
+        return last;
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::vector<Band> m_bands;
+    std::size_t m_head = 0;
+    std::size_t m_count = 0;
+    UInt32 m_images = 0;
+    UInt32 m_maxImages;
+    bool m_cancelled = false;
+
+    // producer, current image
+    Compression m_compression = Compression::None;
+    UInt32 m_bytesPerRow = 0;
+    UInt32 m_columns = 0;
+    UInt32 m_imageRows = 0;
+
+    // consumer, current band
+    UInt32 m_readOffset = 0;
+    UInt32 m_yOffset = 0;
+
+    UInt64 m_producerWaits = 0;
+    UInt64 m_consumerWaits = 0;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_ACQUISITIONRING_HPP
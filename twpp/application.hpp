@@ -54,6 +54,167 @@ struct ManagerData {
 
 };
 
+/// Cache of capability values received from a source.
+/// Entries are keyed by capability type and message.
+struct CapabilityCache {
+
+    static UInt32 key(CapType cap, Msg msg) noexcept{
+        return (static_cast<UInt32>(cap) << 16) | static_cast<UInt16>(msg);
+    }
+
+    static bool cacheable(Msg msg) noexcept{
+        switch (msg){
+            case Msg::Get:
+            case Msg::GetCurrent:
+            case Msg::GetDefault:
+            case Msg::QuerySupport:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    /// Whether the device may change the value of the capability on its own.
+    static bool isVolatile(CapType cap) noexcept{
+        switch (cap){
+            case CapType::XferCount:
+            case CapType::FeederLoaded:
+            case CapType::PaperDetectable:
+            case CapType::DeviceOnline:
+            case CapType::DeviceTimeDate:
+            case CapType::PowerSupply:
+            case CapType::BatteryMinutes:
+            case CapType::BatteryPercentage:
+            case CapType::CameraSide:
+            case CapType::ILampState:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    /// Whether values of the capability are cached, see `setCacheable`.
+    bool cacheable(CapType cap) const noexcept{
+        auto it = m_overrides.find(static_cast<UInt16>(cap));
+        return it != m_overrides.end() ? it->second : !isVolatile(cap);
+    }
+
+    /// Copies cached value into `data`.
+    /// \return Whether the value was cached.
+    bool find(Msg msg, Capability& data){
+        if (m_stale.exchange(false)){
+            clear();
+        }
+
+        auto it = m_entries.find(key(data.type(), msg));
+        if (it == m_entries.end()){
+            m_misses++;
+            return false;
+        }
+
+        try {
+            data = it->second.clone();
+        } catch (const std::bad_alloc&){
+            m_misses++;
+            return false;
+        }
+
+        m_hits++;
+        return true;
+    }
+
+    /// Stores a copy of `data`, capabilities holding handles are not stored.
+    void store(Msg msg, const Capability& data) noexcept{
+        try {
+            if (data && data.itemType() != Type::Handle){
+                m_entries.emplace(key(data.type(), msg), data.clone());
+            }
+        } catch (const std::exception&){
+            // caching is best-effort
+        }
+    }
+
+    /// Removes all values of the capability and its dependents.
+    void invalidate(CapType cap) noexcept{
+        try {
+            invalidateDependents(cap);
+        } catch (const std::bad_alloc&){
+            clear();
+        }
+    }
+
+    void invalidateDependents(CapType cap){
+        std::vector<CapType> pending{cap};
+        std::vector<CapType> done;
+        while (!pending.empty()){
+            auto cur = pending.back();
+            pending.pop_back();
+            if (std::find(done.begin(), done.end(), cur) != done.end()){
+                continue;
+            }
+
+            done.push_back(cur);
+            for (auto it = m_entries.begin(); it != m_entries.end();){
+                if ((it->first >> 16) == static_cast<UInt16>(cur)){
+                    it = m_entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            auto range = m_dependents.equal_range(static_cast<UInt16>(cur));
+            for (auto it = range.first; it != range.second; ++it){
+                pending.push_back(it->second);
+            }
+        }
+    }
+
+    void clear() noexcept{
+        m_entries.clear();
+    }
+
+    bool m_enabled = false;
+    std::atomic<bool> m_stale{false};
+    std::unordered_map<UInt32, Capability> m_entries;
+    std::unordered_multimap<UInt16, CapType> m_dependents;
+    std::unordered_map<UInt16, bool> m_overrides;
+    UInt64 m_hits = 0;
+    UInt64 m_misses = 0;
+
+};
+
+/// Order in which capabilities are negotiated.
+/// Capabilities that constrain others come first, e.g. IPixelType restricts IBitDepth.
+/// Unknown capabilities go last.
+static inline UInt32 negotiationRank(CapType cap) noexcept{
+    switch (cap){
+        case CapType::FeederEnabled: return 10;
+        case CapType::DuplexEnabled:
+        case CapType::AutoFeed:
+        case CapType::AutoScan: return 20;
+        case CapType::IXferMech: return 30;
+        case CapType::IImageFileFormat: return 40;
+        case CapType::ICompression: return 50;
+        case CapType::IPixelType: return 60;
+        case CapType::IBitDepth: return 70;
+        case CapType::IBitDepthReduction: return 80;
+        case CapType::IThreshold:
+        case CapType::IPixelFlavor:
+        case CapType::IJpegQuality: return 90;
+        case CapType::IUnits: return 100;
+        case CapType::IXResolution:
+        case CapType::IYResolution: return 110;
+        case CapType::ISupportedSizes:
+        case CapType::IAutoSize:
+        case CapType::IAutomaticBorderDetection:
+        case CapType::IOrientation: return 120;
+        case CapType::IFrames: return 130;
+        default: return 200;
+    }
+}
+
 struct SourceData {
 
     SourceData(ManagerData* mgr, const Identity& srcIdent) noexcept :
@@ -65,6 +226,7 @@ struct SourceData {
     Identity m_srcId;
     DsState m_state = DsState::Closed;
     Msg m_readyMsg = Msg::Null;
+    CapabilityCache m_capCache;
 
 #if defined(TWPP_DETAIL_OS_LINUX)
     std::mutex m_cbMutex;
@@ -79,6 +241,52 @@ struct SourceData {
 
 class Manager;
 
+/// Result of negotiating a single capability, see `Source::negotiate`.
+class NegotiationResult {
+
+public:
+    /// Creates result of a capability that was not negotiated.
+    constexpr NegotiationResult(CapType cap = CapType()) noexcept :
+        m_cap(cap), m_rc(ReturnCode::Failure), m_status(), m_attempted(false), m_skipped(false){}
+
+    constexpr NegotiationResult(CapType cap, ReturnCode rc, Status status, bool skipped) noexcept :
+        m_cap(cap), m_rc(rc), m_status(status), m_attempted(true), m_skipped(skipped){}
+
+    /// Capability type.
+    constexpr CapType cap() const noexcept{
+        return m_cap;
+    }
+
+    /// Return code of the negotiation, Failure if not attempted.
+    constexpr ReturnCode returnCode() const noexcept{
+        return m_rc;
+    }
+
+    /// Status of the source, valid when the negotiation failed.
+    constexpr Status status() const noexcept{
+        return m_status;
+    }
+
+    /// Whether the capability was negotiated at all.
+    /// False if the negotiation stopped before reaching this capability.
+    constexpr bool attempted() const noexcept{
+        return m_attempted;
+    }
+
+    /// Whether Set was skipped because the current value already matched.
+    constexpr bool skipped() const noexcept{
+        return m_skipped;
+    }
+
+private:
+    CapType m_cap;
+    ReturnCode m_rc;
+    Status m_status;
+    bool m_attempted;
+    bool m_skipped;
+
+};
+
 /// A single TWAIN source.
 /// Source must belong to a manager in order to perform operations on it.
 /// Any valid source instance must be destroyed or at least cleaned by `cleanup`
@@ -186,6 +394,116 @@ public:
         d()->m_devEvent = std::move(devEvent);
     }
 
+    /// Capability cache statistics.
+    class CapabilityCacheStats {
+
+    public:
+        constexpr CapabilityCacheStats() noexcept :
+            m_hits(0), m_misses(0), m_entries(0){}
+
+        constexpr CapabilityCacheStats(UInt64 hits, UInt64 misses, UInt64 entries) noexcept :
+            m_hits(hits), m_misses(misses), m_entries(entries){}
+
+        /// Number of capability operations answered from the cache.
+        constexpr UInt64 hits() const noexcept{
+            return m_hits;
+        }
+
+        /// Number of cacheable capability operations sent to the source.
+        constexpr UInt64 misses() const noexcept{
+            return m_misses;
+        }
+
+        /// Number of cached capability values.
+        constexpr UInt64 entries() const noexcept{
+            return m_entries;
+        }
+
+    private:
+        UInt64 m_hits;
+        UInt64 m_misses;
+        UInt64 m_entries;
+
+    };
+
+    /// Enables caching of capability values.
+    /// Get, GetCurrent, GetDefault and QuerySupport results are cached
+    /// and returned as copies without contacting the source.
+    /// Set, Reset and SetConstraint drop the values of that capability
+    /// and of its dependents, see `addCapabilityDependency`.
+    /// ResetAll, device events, enabling, disabling and closing the source
+    /// and the end of each transfer drop all values.
+    /// Capabilities holding handles are never cached, neither are capabilities
+    /// the device changes on its own, e.g. FeederLoaded, see `setCapabilityCacheable`.
+    void enableCapabilityCache() noexcept{
+        assert(isValid());
+
+        d()->m_capCache.m_enabled = true;
+    }
+
+    /// Disables capability cache and drops all cached values.
+    void disableCapabilityCache() noexcept{
+        assert(isValid());
+
+        d()->m_capCache.m_enabled = false;
+        d()->m_capCache.clear();
+    }
+
+    /// Whether capability cache is enabled.
+    bool isCapabilityCacheEnabled() const noexcept{
+        assert(isValid());
+
+        return d()->m_capCache.m_enabled;
+    }
+
+    /// Drops all cached capability values.
+    void invalidateCapabilityCache() noexcept{
+        assert(isValid());
+
+        d()->m_capCache.clear();
+    }
+
+    /// Sets whether values of the capability are cached, overriding the built-in choice.
+    /// Capabilities the device changes on its own (XferCount, FeederLoaded, PaperDetectable,
+    /// DeviceOnline, DeviceTimeDate, PowerSupply, BatteryMinutes, BatteryPercentage,
+    /// CameraSide, ILampState) are not cached by default, all others are.
+    /// \throw std::bad_alloc
+    void setCapabilityCacheable(CapType cap, bool cacheable){
+        assert(isValid());
+
+        auto& cache = d()->m_capCache;
+        cache.m_overrides[static_cast<UInt16>(cap)] = cacheable;
+        if (!cacheable){
+            cache.invalidate(cap);
+        }
+    }
+
+    /// Marks `dependent` to be dropped from the cache whenever `cap` changes.
+    /// For example IBitDepth depends on IPixelType.
+    /// Dependencies are transitive.
+    /// \throw std::bad_alloc
+    void addCapabilityDependency(CapType cap, CapType dependent){
+        assert(isValid());
+
+        d()->m_capCache.m_dependents.emplace(static_cast<UInt16>(cap), dependent);
+    }
+
+    /// Capability cache statistics.
+    CapabilityCacheStats capabilityCacheStats() const noexcept{
+        assert(isValid());
+
+        auto& cache = d()->m_capCache;
+        return {cache.m_hits, cache.m_misses, cache.m_entries.size()};
+    }
+
+    /// Resets capability cache hit and miss counters.
+    void resetCapabilityCacheStats() noexcept{
+        assert(isValid());
+
+        d()->m_capCache.m_hits = 0;
+        d()->m_capCache.m_misses = 0;
+    }
+
 
     // Control ->
 
@@ -237,6 +555,7 @@ public:
         if (success(rc)){
             Static<void>::g_openSource = nullptr;
             d()->m_state = DsState::Closed;
+            d()->m_capCache.clear();
         }
 
         return rc;
@@ -258,6 +577,9 @@ public:
         d()->m_state = DsState::Enabled;
         d()->m_readyMsg = Msg::Null;
 
+        // the source may change values once a scan session starts
+        d()->m_capCache.clear();
+
         auto uiTmp = ui; // allow ui to be const, dsm doesnt take const
         ReturnCode rc = dsm(DataGroup::Control, Dat::UserInterface, uiOnly ? Msg::EnableDsUiOnly : Msg::EnableDs, uiTmp);       
         if (!success(rc) && (ui.showUi() || rc != ReturnCode::CheckStatus)){
@@ -278,6 +600,7 @@ public:
         auto rc = dsm(DataGroup::Control, Dat::UserInterface, Msg::DisableDs, ui);
         if (success(rc)){
             d()->m_state = DsState::Open;
+            d()->m_capCache.clear();
         }
 
         return rc;
@@ -357,6 +680,7 @@ public:
                 return ReturnCode::Cancel;
 
             case Msg::DeviceEvent:
+                d()->m_capCache.clear();
                 return ReturnCode::CheckStatus;
 
             default:
@@ -418,6 +742,7 @@ public:
                 return ReturnCode::Cancel;
 
             case Msg::DeviceEvent:
+                d()->m_capCache.clear();
                 return ReturnCode::CheckStatus;
 
             case Msg::Null:
@@ -465,6 +790,83 @@ public:
         return call(DataGroup::Control, msg, inOut);
     }
 
+    /// Sets multiple capabilities at once.
+    /// The capabilities are set in their dependency order, not in the order of the profile.
+    /// The profile itself is left as is, each capability is set through a copy.
+    /// Capabilities whose current value already equals the desired one are not set,
+    /// enable capability cache to avoid querying the current values from the source.
+    /// \param profile Desired capability values, usually OneValue containers.
+    /// \param stopOnUnsupported Whether to stop at the first capability the source does not support.
+    /// \param skipUnchanged {Whether to compare with current values first.
+    /// Pass false when the profile is already known to differ, e.g. from `ScanProfile::diff`.}
+    /// \return Result for each capability, in the order of the profile.
+    /// \throw std::bad_alloc
+    std::vector<NegotiationResult> negotiate(const std::vector<Capability>& profile, bool stopOnUnsupported = true,
+                                             bool skipUnchanged = true){
+        assert(isValid());
+
+        std::vector<NegotiationResult> results;
+        results.reserve(profile.size());
+        for (const auto& cap : profile){
+            results.emplace_back(cap.type());
+        }
+
+        std::vector<std::size_t> order(profile.size());
+        for (std::size_t i = 0; i < order.size(); i++){
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&profile](std::size_t a, std::size_t b){
+            return Detail::negotiationRank(profile[a].type()) < Detail::negotiationRank(profile[b].type());
+        });
+
+        for (auto i : order){
+            const auto& desired = profile[i];
+
+            bool unsupported = false;
+            Status stat;
+            auto rc = ReturnCode::Success;
+            if (skipUnchanged){
+                Capability current(desired.type());
+                rc = capability(Msg::GetCurrent, current);
+                bool same = false;
+                try {
+                    same = rc == ReturnCode::Success && current.sameValues(desired);
+                } catch (const Exception&){
+                    // malformed container from the source, set the value
+                }
+
+                if (same){
+                    results[i] = NegotiationResult(desired.type(), rc, Status(), true);
+                    continue;
+                }
+
+                if (rc == ReturnCode::Failure){
+                    status(stat);
+                    unsupported = stat.condition() == ConditionCode::CapUnsupported;
+                }
+            }
+
+            if (!unsupported){
+                // the source is free to change the container it is given
+                auto value = desired.clone();
+                rc = capability(Msg::Set, value);
+                stat = Status();
+                if (rc == ReturnCode::Failure || rc == ReturnCode::CheckStatus){
+                    status(stat);
+                    unsupported = stat.condition() == ConditionCode::CapUnsupported;
+                }
+            }
+
+            results[i] = NegotiationResult(desired.type(), rc, stat, false);
+            if (unsupported && stopOnUnsupported){
+                break;
+            }
+        }
+
+        return results;
+    }
+
     ReturnCode customData(Msg msg, CustomData& inOut){
         return call(DataGroup::Control, msg, inOut);
     }
@@ -583,7 +985,47 @@ public:
 
     // dg:: control follows
     ReturnCode call(DataGroup dg, Msg msg, Capability& data){
-        return dsm(dg, Dat::Capability, msg, data);
+        auto& cache = d()->m_capCache;
+        if (!cache.m_enabled){
+            return dsm(dg, Dat::Capability, msg, data);
+        }
+
+        if (Detail::CapabilityCache::cacheable(msg)){
+            if (!cache.cacheable(data.type())){
+                return dsm(dg, Dat::Capability, msg, data);
+            }
+
+            if (cache.find(msg, data)){
+                return ReturnCode::Success;
+            }
+
+            auto rc = dsm(dg, Dat::Capability, msg, data);
+            if (rc == ReturnCode::Success){
+                cache.store(msg, data);
+            }
+
+            return rc;
+        }
+
+        auto cap = data.type();
+        auto rc = dsm(dg, Dat::Capability, msg, data);
+        switch (msg){
+            case Msg::Set:
+            case Msg::Reset:
+            case Msg::SetConstraint:
+                // CheckStatus on Set means the source changed the value
+                cache.invalidate(cap);
+                break;
+
+            case Msg::ResetAll:
+                cache.clear();
+                break;
+
+            default:
+                break;
+        }
+
+        return rc;
     }
 
     /// \throw CapTypeException When input capability type does not match the
@@ -620,6 +1062,7 @@ public:
             DataGroup xg = DataGroup::Image;
             switch (msg){
                 case Msg::EndXfer:
+                    d()->m_capCache.clear();
                     xferGroup(Msg::Get, xg);
                     if (xg == DataGroup::Image && data.count() == 0){
                         d()->m_state = DsState::Enabled;
@@ -847,6 +1290,8 @@ private:
 #   error "callBack preparation for your platform here"
 #endif
         if (msg == Msg::DeviceEvent){
+            // may run in a DSM thread, the cache is dropped on its next use
+            src->m_capCache.m_stale = true;
             if (!src->m_devEvent){
                 return ReturnCode::Failure;
             }
@@ -1007,7 +1452,12 @@ public:
             if (d()->m_appId.isDsmV2()){
                 Detail::EntryPoint e;
                 if (success(dsm(nullptr, DataGroup::Control, Dat::EntryPoint, Msg::Get, e))){
-                    Detail::setMemFuncs(e.m_alloc, e.m_free, e.m_lock, e.m_unlock);
+                    try {
+                        Detail::setMemFuncs(e.m_alloc, e.m_free, e.m_lock, e.m_unlock);
+                    } catch (const std::bad_alloc&){
+                        dsm(nullptr, DataGroup::Control, Dat::Parent, Msg::CloseDsm, rootWindow);
+                        return ReturnCode::Failure;
+                    }
                 }
             }
 
@@ -276,6 +276,27 @@ struct ArrayData {
     Type m_itemType;
     UInt32 m_numItems;
     DataType m_items[1];
+
+    /// Index of the first item equal to the value, or `m_numItems` if there is none.
+    UInt32 indexOf(const DataType& value) const noexcept{
+        return findItem(m_items, m_numItems, value);
+    }
+
+    bool contains(const DataType& value) const noexcept{
+        return indexOf(value) != m_numItems;
+    }
+
+    /// The first item equal to the value, or null if there is none.
+    const DataType* find(const DataType& value) const noexcept{
+        auto i = indexOf(value);
+        return i != m_numItems ? m_items + i : nullptr;
+    }
+
+    /// Smallest and largest item.
+    /// \return False if there are no items.
+    bool minMax(DataType& min, DataType& max) const noexcept{
+        return minMaxItems(m_items, m_numItems, min, max);
+    }
 };
 
 template<typename DataType>
@@ -285,6 +306,27 @@ struct EnumerationData {
     UInt32 m_currIndex;
     UInt32 m_defIndex;
     DataType m_items[1];
+
+    /// Index of the first item equal to the value, or `m_numItems` if there is none.
+    UInt32 indexOf(const DataType& value) const noexcept{
+        return findItem(m_items, m_numItems, value);
+    }
+
+    bool contains(const DataType& value) const noexcept{
+        return indexOf(value) != m_numItems;
+    }
+
+    /// The first item equal to the value, or null if there is none.
+    const DataType* find(const DataType& value) const noexcept{
+        auto i = indexOf(value);
+        return i != m_numItems ? m_items + i : nullptr;
+    }
+
+    /// Smallest and largest item.
+    /// \return False if there are no items.
+    bool minMax(DataType& min, DataType& max) const noexcept{
+        return minMaxItems(m_items, m_numItems, min, max);
+    }
 };
 
 // Range items are always 4 bytes large,
@@ -346,6 +388,30 @@ struct IsNumeric {
     static constexpr bool value = std::is_integral<DataType>::value || std::is_same<DataType, Fix32>::value;
 };
 
+/// Exact integer representation of numeric range values.
+/// Fix32 is represented in 1/65536 units.
+template<typename DataType>
+struct RangeMath {
+    static constexpr Int64 toRaw(DataType value) noexcept{
+        return static_cast<Int64>(value);
+    }
+
+    static constexpr DataType fromRaw(Int64 raw) noexcept{
+        return static_cast<DataType>(raw);
+    }
+};
+
+template<>
+struct RangeMath<Fix32> {
+    static constexpr Int64 toRaw(Fix32 value) noexcept{
+        return value.raw();
+    }
+
+    static constexpr Fix32 fromRaw(Int64 raw) noexcept{
+        return Fix32::fromRaw(static_cast<Int32>(raw));
+    }
+};
+
 }
 
 class Capability;
@@ -477,6 +543,23 @@ public:
         return at(i);
     }
 
+    /// Index of the first item equal to the value, or `size()` if there is none.
+    /// Numeric items are compared using SIMD if available.
+    UInt32 indexOf(const DataType& value) const noexcept{
+        return m_data->indexOf(value);
+    }
+
+    /// Whether the value is an item of the container.
+    bool contains(const DataType& value) const noexcept{
+        return m_data->contains(value);
+    }
+
+    /// Smallest and largest item.
+    /// \return False if there are no items.
+    bool minMax(DataType& min, DataType& max) const noexcept{
+        return m_data->minMax(min, max);
+    }
+
     operator bool() const noexcept{
         return m_data;
     }
@@ -624,6 +707,23 @@ public:
         return at(i);
     }
 
+    /// Index of the first item equal to the value, or `size()` if there is none.
+    /// Numeric items are compared using SIMD if available.
+    UInt32 indexOf(const DataType& value) const noexcept{
+        return m_data->indexOf(value);
+    }
+
+    /// Whether the value is an item of the container.
+    bool contains(const DataType& value) const noexcept{
+        return m_data->contains(value);
+    }
+
+    /// Smallest and largest item.
+    /// \return False if there are no items.
+    bool minMax(DataType& min, DataType& max) const noexcept{
+        return m_data->minMax(min, max);
+    }
+
     operator bool() const noexcept{
         return m_data;
     }
@@ -679,6 +779,9 @@ class Range {
 
 private:
     static constexpr const ConType contype = ConType::Range;
+    typedef Detail::RangeMath<DataType> Math;
+
+    /// Iterates over range items by index, each item is computed exactly as `min + index * step`.
     template<typename IterDataType>
     class IteratorImpl {
 
@@ -686,41 +789,36 @@ private:
 
     public:
         constexpr IteratorImpl() noexcept :
-            m_curr(), m_parent(nullptr){}
+            m_index(0), m_parent(nullptr){}
 
         IterDataType operator*() const noexcept{
-            return m_curr;
+            return m_parent->at(m_index);
         }
 
         IteratorImpl& operator++() noexcept{ // prefix
-            m_curr += step();
-            checkValue();
+            ++m_index;
             return *this;
         }
 
         IteratorImpl operator++(int) noexcept{ // postfix
             IteratorImpl ret(*this);
-            m_curr += step();
-            checkValue();
+            ++m_index;
             return ret;
         }
 
         IteratorImpl& operator--() noexcept{ // prefix
-            m_curr -= step();
+            --m_index;
             return *this;
         }
 
         IteratorImpl operator--(int) noexcept{ // postfix
             IteratorImpl ret(*this);
-            m_curr -= step();
+            --m_index;
             return ret;
         }
 
         bool operator==(const IteratorImpl& o) const noexcept{
-            return m_curr == o.m_curr &&
-                    (m_parent == o.m_parent ||
-                        (m_parent && o.m_parent && step() == o.step())
-                     );
+            return m_index == o.m_index && m_parent == o.m_parent;
         }
 
         bool operator!=(const IteratorImpl& o) const noexcept{
@@ -728,25 +826,10 @@ private:
         }
 
     private:
-        IterDataType step() const noexcept{
-            return m_parent->stepSize();
-        }
-
-        IterDataType max() const noexcept{
-            return m_parent->maxValue();
-        }
+        IteratorImpl(UInt32 index, const Range& parent) noexcept :
+            m_index(index), m_parent(&parent){}
 
-        void checkValue() noexcept{
-            // avoid infinite loops in case no such N exists: `min + N * step == max`
-            if (m_curr > max()){
-                m_curr = max() + step();
-            }
-        }
-
-        IteratorImpl(IterDataType curr, const Range& parent) noexcept :
-            m_curr(curr), m_parent(&parent){}
-
-        IterDataType m_curr;
+        UInt32 m_index;
         const Range* m_parent;
 
     };
@@ -821,7 +904,7 @@ public:
     }
 
     const_iterator cbegin() const noexcept{
-        return const_iterator(m_data->m_minValue, *this);
+        return const_iterator(0, *this);
     }
 
     const_iterator end() const noexcept{
@@ -829,12 +912,51 @@ public:
     }
 
     const_iterator cend() const noexcept{
-        auto step = m_data->m_stepSize;
-        if (step != DataType()){
-            return const_iterator(m_data->m_maxValue + step, *this);
-        } else {
-            return cbegin(); // no items with step equal to zero
+        return const_iterator(size(), *this);
+    }
+
+    /// Number of items in the range: `min + N * step` for all N such that the value is not greater than max.
+    /// Zero if step is not positive or max is smaller than min.
+    /// Saturates at the largest UInt32, e.g. for a full-width UInt32 range with step 1;
+    /// items past that index are not accessible by index, use `contains` to test them.
+    UInt32 size() const noexcept{
+        auto step = Math::toRaw(stepSize());
+        auto min = Math::toRaw(minValue());
+        auto max = Math::toRaw(maxValue());
+        if (step <= 0 || max < min){
+            return 0;
+        }
+
+        auto count = static_cast<UInt64>((max - min) / step) + 1;
+        return static_cast<UInt32>(std::min<UInt64>(count, std::numeric_limits<UInt32>::max()));
+    }
+
+    /// Item at the supplied index, computed exactly as `min + index * step`.
+    /// \param index Item index, must be smaller than `size()`.
+    DataType at(UInt32 index) const noexcept{
+        assert(index < size());
+        return Math::fromRaw(Math::toRaw(minValue()) + static_cast<Int64>(index) * Math::toRaw(stepSize()));
+    }
+
+    /// Index of the item, or `size()` if the value is not in the range
+    /// or its index is not smaller than the saturated `size()`.
+    UInt32 indexOf(DataType value) const noexcept{
+        auto count = size();
+        if (!contains(value)){
+            return count;
         }
+
+        auto index = (Math::toRaw(value) - Math::toRaw(minValue())) / Math::toRaw(stepSize());
+        return index < count ? static_cast<UInt32>(index) : count;
+    }
+
+    /// Whether the value is an item of the range.
+    bool contains(DataType value) const noexcept{
+        auto step = Math::toRaw(stepSize());
+        auto min = Math::toRaw(minValue());
+        auto max = Math::toRaw(maxValue());
+        auto raw = Math::toRaw(value);
+        return step > 0 && raw >= min && raw <= max && (raw - min) % step == 0;
     }
 
 private:
@@ -864,6 +986,74 @@ template<typename DataType>
 class Range<Type::Str255, DataType>;
 
 
+/// Contiguous items of OneValue, Array or Enumeration container, see `Capability::visit`.
+/// Valid only during the visit.
+/// \tparam twty ID of the internal data type.
+/// \tparam DataType Exported data type.
+template<Type twty, typename DataType = typename Detail::Twty<twty>::Type>
+class ItemSpan {
+
+    friend class Capability;
+
+public:
+    typedef const DataType* const_iterator;
+
+    /// Container type.
+    ConType container() const noexcept{
+        return m_conType;
+    }
+
+    /// Item type.
+    Type type() const noexcept{
+        return twty;
+    }
+
+    /// Number of items.
+    UInt32 size() const noexcept{
+        return m_size;
+    }
+
+    /// Pointer to the first item.
+    const DataType* data() const noexcept{
+        return m_items;
+    }
+
+    const DataType& operator[](UInt32 i) const noexcept{
+        assert(i < m_size);
+        return m_items[i];
+    }
+
+    const_iterator begin() const noexcept{
+        return m_items;
+    }
+
+    const_iterator end() const noexcept{
+        return m_items + m_size;
+    }
+
+    /// Index of the current item, zero for OneValue, `size()` for Array.
+    UInt32 currentIndex() const noexcept{
+        return m_currIndex;
+    }
+
+    /// Index of the default item, zero for OneValue, `size()` for Array.
+    UInt32 defaultIndex() const noexcept{
+        return m_defIndex;
+    }
+
+private:
+    ItemSpan(ConType conType, const DataType* items, UInt32 size, UInt32 currIndex, UInt32 defIndex) noexcept :
+        m_conType(conType), m_items(items), m_size(size), m_currIndex(currIndex), m_defIndex(defIndex){}
+
+    ConType m_conType;
+    const DataType* m_items;
+    UInt32 m_size;
+    UInt32 m_currIndex;
+    UInt32 m_defIndex;
+
+};
+
+
 namespace Detail {
 
 template<Type type, bool, typename DataType>
@@ -1151,14 +1341,8 @@ public:
                 return reinterpret_cast<Detail::ArrayData<DataType>*>(m_data.data())->m_numItems;
             case ConType::OneValue:
                 return 1;
-            case ConType::Range: {
-                auto& rng = *reinterpret_cast<Detail::RangeData<DataType>*>(m_data.data());
-                if (rng.m_stepSize != DataType()){
-                    return static_cast<UInt32>(static_cast<float>(Detail::abs(rng.m_maxValue - rng.m_minValue) / rng.m_stepSize)) + 1;
-                } else {
-                    return 0;
-                }
-            }
+            case ConType::Range:
+                return Detail::alias_cast<const Range<type, DataType>*>(&m_data)->size();
             default:
                 return 0; // should not happen
         }
@@ -1283,6 +1467,8 @@ class Capability {
     template<Type, bool, typename>
     friend class Detail::CapDataImpl;
 
+    friend class ScanProfile;
+
 public:
     /// Creates capability holding OneValue container.
     /// \tparam type ID of the internal data type.
@@ -1627,6 +1813,99 @@ public:
     Capability(Capability&&) = default;
     Capability& operator=(Capability&&) = default;
 
+    /// Creates a deep copy of this capability.
+    /// Empty capability is copied without any data.
+    /// \throw ItemTypeException When the items are handles, these can not be shared.
+    /// \throw std::bad_alloc
+    Capability clone() const{
+        if (!m_cont){
+            return Capability(m_cap);
+        }
+
+        auto twty = itemType();
+        if (twty == Type::Handle){
+            throw ItemTypeException();
+        }
+
+        auto size = dataSize(twty, false);
+        if (size > std::numeric_limits<UInt32>::max()){
+            throw ContainerException();
+        }
+
+        Capability ret(m_cap, m_conType, twty, static_cast<UInt32>(size));
+        std::memcpy(ret.m_cont.lock<char>().data(), m_cont.lock<char>().data(), size);
+        return ret;
+    }
+
+    /// Whether both capabilities are of the same type and contain the same data.
+    /// Compares container type, item type and the items, for OneValue
+    /// only the significant bytes of the item are compared.
+    /// Handle items are compared by value.
+    bool sameData(const Capability& o) const{
+        if (m_cap != o.m_cap || static_cast<bool>(m_cont) != static_cast<bool>(o.m_cont)){
+            return false;
+        }
+
+        if (!m_cont){
+            return true;
+        }
+
+        if (m_conType != o.m_conType){
+            return false;
+        }
+
+        auto twty = itemType();
+        if (twty != o.itemType()){
+            return false;
+        }
+
+        auto size = dataSize(twty, true);
+        if (size != o.dataSize(twty, true)){
+            return false;
+        }
+
+        return std::memcmp(m_cont.lock<char>().data(), o.m_cont.lock<char>().data(), size) == 0;
+    }
+
+    /// Whether both capabilities are of the same type and hold equal values.
+    /// Unlike `sameData`, items are compared by value, e.g. strings
+    /// ignore everything past the terminating null character.
+    /// Enumerations compare their current and default indexes too.
+    /// \throw ContainerException When the container type is invalid.
+    /// \throw TypeException When the item type is invalid.
+    bool sameValues(const Capability& o) const{
+        if (m_cap != o.m_cap || static_cast<bool>(m_cont) != static_cast<bool>(o.m_cont)){
+            return false;
+        }
+
+        if (!m_cont){
+            return true;
+        }
+
+        auto twty = itemType();
+        if (m_conType != o.m_conType || twty != o.itemType()){
+            return false;
+        }
+
+        switch (twty){
+            case Type::Int8: return sameValues<Type::Int8>(o);
+            case Type::Int16: return sameValues<Type::Int16>(o);
+            case Type::Int32: return sameValues<Type::Int32>(o);
+            case Type::UInt8: return sameValues<Type::UInt8>(o);
+            case Type::UInt16: return sameValues<Type::UInt16>(o);
+            case Type::UInt32: return sameValues<Type::UInt32>(o);
+            case Type::Bool: return sameValues<Type::Bool>(o);
+            case Type::Fix32: return sameValues<Type::Fix32>(o);
+            case Type::Frame: return sameValues<Type::Frame>(o);
+            case Type::Str32: return sameValues<Type::Str32>(o);
+            case Type::Str64: return sameValues<Type::Str64>(o);
+            case Type::Str128: return sameValues<Type::Str128>(o);
+            case Type::Str255: return sameValues<Type::Str255>(o);
+            case Type::Handle: return sameValues<Type::Handle>(o);
+            default: throw TypeException();
+        }
+    }
+
     /// Capability type.
     CapType type() const noexcept{
         return m_cap;
@@ -1865,6 +2144,35 @@ public:
     }
 
 
+    /// Passes contents of the capability to the visitor, dispatching on container and item type once.
+    /// OneValue, Array and Enumeration containers are passed as `const ItemSpan<type, DataType>&`,
+    /// numeric Range containers as `const Range<type, DataType>&`.
+    /// The visitor must accept both for every item type, e.g. using template `operator()`.
+    /// Data is locked only during the call.
+    /// \throw DataException When there is no data.
+    /// \throw ContainerException When the container type is invalid, or Range of non-numeric type.
+    /// \throw TypeException When the item type is invalid.
+    template<typename Visitor>
+    void visit(Visitor&& visitor) const{
+        switch (itemType()){
+            case Type::Int8: visitImpl<Type::Int8>(visitor); break;
+            case Type::Int16: visitImpl<Type::Int16>(visitor); break;
+            case Type::Int32: visitImpl<Type::Int32>(visitor); break;
+            case Type::UInt8: visitImpl<Type::UInt8>(visitor); break;
+            case Type::UInt16: visitImpl<Type::UInt16>(visitor); break;
+            case Type::UInt32: visitImpl<Type::UInt32>(visitor); break;
+            case Type::Bool: visitImpl<Type::Bool>(visitor); break;
+            case Type::Fix32: visitImpl<Type::Fix32>(visitor); break;
+            case Type::Frame: visitImpl<Type::Frame>(visitor); break;
+            case Type::Str32: visitImpl<Type::Str32>(visitor); break;
+            case Type::Str64: visitImpl<Type::Str64>(visitor); break;
+            case Type::Str128: visitImpl<Type::Str128>(visitor); break;
+            case Type::Str255: visitImpl<Type::Str255>(visitor); break;
+            case Type::Handle: visitImpl<Type::Handle>(visitor); break;
+            default: throw TypeException();
+        }
+    }
+
     /// Whether the current item can be retrieved.
     /// The container must be one of Enumeration, OneValue, and Range.
     bool hasCurrentItem() const noexcept{
@@ -1924,7 +2232,384 @@ public:
         return currentItem<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>();
     }
 
+    /// Sets OneValue container with the supplied value.
+    /// Reuses the current container if it is OneValue of the same item type,
+    /// allocates a new one otherwise.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    /// \param value New value.
+    /// \throw std::bad_alloc
+    template<Type type, typename DataType>
+    void assignOneValue(const DataType& value){
+        if (!reusable<DataType>(ConType::OneValue, type, sizeof(Detail::OneValueData<DataType>))){
+            *this = createOneValue<type, DataType>(m_cap, value);
+            return;
+        }
+
+        oneValue<type, DataType>().setItem(value);
+    }
+
+    /// Sets OneValue container with the supplied value.
+    /// Reuses the current container if possible.
+    /// \tparam type ID of the internal data type.
+    /// \param value New value.
+    /// \throw std::bad_alloc
+    template<Type type>
+    void assignOneValue(const typename Detail::Twty<type>::Type& value){
+        assignOneValue<type, typename Detail::Twty<type>::Type>(value);
+    }
+
+    /// Sets OneValue container with the supplied value.
+    /// Reuses the current container if possible.
+    /// \tparam T Data type.
+    /// \param value New value.
+    /// \throw std::bad_alloc
+    template<typename T>
+    void assignOneValue(const T& value){
+        assignOneValue<Detail::Tytw<T>::twty, T>(value);
+    }
+
+    /// Sets OneValue container with the supplied value.
+    /// Reuses the current container if possible.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \param value New value.
+    /// \throw std::bad_alloc
+    template<CapType cap>
+    void assignOneValue(const typename Detail::Cap<cap>::DataType& value){
+        assignOneValue<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(value);
+    }
+
+
+    /// Sets Array container with the supplied values.
+    /// Reuses the current container if it is Array of the same item type
+    /// that can hold all the values, allocates a new one otherwise.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    /// \param values New values.
+    /// \throw std::bad_alloc
+    template<Type type, typename DataType>
+    void assignArray(std::initializer_list<DataType> values){
+        auto size = static_cast<UInt32>(values.size());
+        if (!reusable<DataType>(ConType::Array, type, sizeof(Detail::ArrayData<DataType>) - sizeof(DataType) + size * sizeof(DataType))){
+            *this = createArray<type, DataType>(m_cap, values);
+            return;
+        }
+
+        auto arr = array<type, DataType>();
+        arr.m_data->m_numItems = size;
+        std::copy(values.begin(), values.end(), arr.begin());
+    }
+
+    /// Sets Array container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam type ID of the internal data type.
+    /// \param values New values.
+    /// \throw std::bad_alloc
+    template<Type type>
+    void assignArray(std::initializer_list<typename Detail::Twty<type>::Type> values){
+        assignArray<type, typename Detail::Twty<type>::Type>(values);
+    }
+
+    /// Sets Array container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam T Data type.
+    /// \param values New values.
+    /// \throw std::bad_alloc
+    template<typename T>
+    void assignArray(std::initializer_list<T> values){
+        assignArray<Detail::Tytw<T>::twty, T>(values);
+    }
+
+    /// Sets Array container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \param values New values.
+    /// \throw std::bad_alloc
+    template<CapType cap>
+    void assignArray(std::initializer_list<typename Detail::Cap<cap>::DataType> values){
+        assignArray<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(values);
+    }
+
+
+    /// Sets Enumeration container with the supplied values.
+    /// Reuses the current container if it is Enumeration of the same item type
+    /// that can hold all the values, allocates a new one otherwise.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    /// \param values New values.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<Type type, typename DataType>
+    void assignEnumeration(std::initializer_list<DataType> values, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        auto size = static_cast<UInt32>(values.size());
+        if (!reusable<DataType>(ConType::Enumeration, type, sizeof(Detail::EnumerationData<DataType>) - sizeof(DataType) + size * sizeof(DataType))){
+            *this = createEnumeration<type, DataType>(m_cap, values, currIndex, defIndex);
+            return;
+        }
+
+        auto enm = enumeration<type, DataType>();
+        enm.m_data->m_numItems = size;
+        enm.setCurrentIndex(currIndex);
+        enm.setDefaultIndex(defIndex);
+        std::copy(values.begin(), values.end(), enm.begin());
+    }
+
+    /// Sets Enumeration container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam type ID of the internal data type.
+    /// \param values New values.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<Type type>
+    void assignEnumeration(std::initializer_list<typename Detail::Twty<type>::Type> values, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        assignEnumeration<type, typename Detail::Twty<type>::Type>(values, currIndex, defIndex);
+    }
+
+    /// Sets Enumeration container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam T Data type.
+    /// \param values New values.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<typename T>
+    void assignEnumeration(std::initializer_list<T> values, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        assignEnumeration<Detail::Tytw<T>::twty, T>(values, currIndex, defIndex);
+    }
+
+    /// Sets Enumeration container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \param values New values.
+    /// \param currIndex Index of the currently selected item.
+    /// \param defIndex Index of the default item.
+    /// \throw std::bad_alloc
+    template<CapType cap>
+    void assignEnumeration(std::initializer_list<typename Detail::Cap<cap>::DataType> values, UInt32 currIndex = 0, UInt32 defIndex = 0){
+        assignEnumeration<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(values, currIndex, defIndex);
+    }
+
+
+    /// Sets Range container with the supplied values.
+    /// Reuses the current container if it is Range of the same item type,
+    /// allocates a new one otherwise.
+    /// \tparam type ID of the internal data type.
+    /// \tparam DataType Exported data type.
+    /// \param min Minimal range value.
+    /// \param max Maximal range value.
+    /// \param step Size of a single step.
+    /// \param curr Current value.
+    /// \param def Default value.
+    /// \throw std::bad_alloc
+    template<Type type, typename DataType>
+    void assignRange(DataType min, DataType max, DataType step, DataType curr, DataType def){
+        if (!reusable<DataType>(ConType::Range, type, sizeof(Detail::RangeData<DataType>))){
+            *this = createRange<type, DataType>(m_cap, min, max, step, curr, def);
+            return;
+        }
+
+        auto rng = range<type, DataType>();
+        rng.setMinValue(min);
+        rng.setMaxValue(max);
+        rng.setStepSize(step);
+        rng.setCurrentValue(curr);
+        rng.setDefaultValue(def);
+    }
+
+    /// Sets Range container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam T Data type.
+    /// \param min Minimal range value.
+    /// \param max Maximal range value.
+    /// \param step Size of a single step.
+    /// \param curr Current value.
+    /// \param def Default value.
+    /// \throw std::bad_alloc
+    template<typename T>
+    void assignRange(T min, T max, T step, T curr, T def){
+        assignRange<Detail::Tytw<T>::twty, T>(min, max, step, curr, def);
+    }
+
+    /// Sets Range container with the supplied values.
+    /// Reuses the current container if possible.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \param min Minimal range value.
+    /// \param max Maximal range value.
+    /// \param step Size of a single step.
+    /// \param curr Current value.
+    /// \param def Default value.
+    /// \throw std::bad_alloc
+    template<CapType cap>
+    void assignRange(
+            typename Detail::Cap<cap>::DataType min,
+            typename Detail::Cap<cap>::DataType max,
+            typename Detail::Cap<cap>::DataType step,
+            typename Detail::Cap<cap>::DataType curr,
+            typename Detail::Cap<cap>::DataType def
+    ){
+        assignRange<Detail::Cap<cap>::twty, typename Detail::Cap<cap>::DataType>(min, max, step, curr, def);
+    }
+
 private:
+    /// Size of the container data.
+    /// Computed in 64 bits, item count of a malformed container may not fit the handle.
+    /// \param significant Whether to exclude padding of OneValue items.
+    /// \throw ContainerException
+    UInt64 dataSize(Type twty, bool significant) const{
+        switch (m_conType){
+            case ConType::OneValue:
+                return sizeof(Type) + (significant ? typeSize(twty) : std::max<UInt32>(sizeof(UInt32), typeSize(twty)));
+
+            case ConType::Array:
+                return sizeof(Type) + sizeof(UInt32) +
+                        static_cast<UInt64>(m_cont.lock<Detail::ArrayData<UInt8> >()->m_numItems) * typeSize(twty);
+
+            case ConType::Enumeration:
+                return sizeof(Type) + 3 * sizeof(UInt32) +
+                        static_cast<UInt64>(m_cont.lock<Detail::EnumerationData<UInt8> >()->m_numItems) * typeSize(twty);
+
+            case ConType::Range:
+                return sizeof(Detail::RangeData<UInt32>);
+
+            default:
+                throw ContainerException();
+        }
+    }
+
+    template<Type type>
+    bool sameValues(const Capability& o) const{
+        typedef typename Detail::Twty<type>::Type DataType;
+
+        switch (m_conType){
+            case ConType::Range:
+                return sameRange<DataType>(o, std::integral_constant<bool, Detail::IsNumeric<DataType>::value>());
+
+            case ConType::Enumeration: {
+                auto a = m_cont.lock<Detail::EnumerationData<DataType> >();
+                auto b = o.m_cont.lock<Detail::EnumerationData<DataType> >();
+                if (a->m_currIndex != b->m_currIndex || a->m_defIndex != b->m_defIndex){
+                    return false;
+                }
+            }
+            // fallthrough
+
+            case ConType::OneValue:
+            case ConType::Array: {
+                auto a = data<type, DataType>();
+                auto b = o.data<type, DataType>();
+                if (a.size() != b.size()){
+                    return false;
+                }
+
+                for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib){
+                    if (!(*ia == *ib)){
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            default:
+                throw ContainerException();
+        }
+    }
+
+    template<Type type, typename Visitor>
+    void visitImpl(Visitor& visitor) const{
+        typedef typename Detail::Twty<type>::Type DataType;
+
+        switch (m_conType){
+            case ConType::OneValue: {
+                auto data = m_cont.lock<Detail::OneValueData<DataType> >();
+                // the item is stored at the beginning of its padding
+                auto item = reinterpret_cast<const DataType*>(&data->m_item);
+                visitor(ItemSpan<type, DataType>(m_conType, item, 1, 0, 0));
+                break;
+            }
+
+            case ConType::Array: {
+                auto data = m_cont.lock<Detail::ArrayData<DataType> >();
+                visitor(ItemSpan<type, DataType>(m_conType, data->m_items, data->m_numItems, data->m_numItems, data->m_numItems));
+                break;
+            }
+
+            case ConType::Enumeration: {
+                auto data = m_cont.lock<Detail::EnumerationData<DataType> >();
+                visitor(ItemSpan<type, DataType>(m_conType, data->m_items, data->m_numItems, data->m_currIndex, data->m_defIndex));
+                break;
+            }
+
+            case ConType::Range:
+                visitRange<type, DataType>(visitor, std::integral_constant<bool, Detail::IsNumeric<DataType>::value>());
+                break;
+
+            default:
+                throw ContainerException();
+        }
+    }
+
+    template<Type type, typename DataType, typename Visitor>
+    void visitRange(Visitor& visitor, std::true_type) const{
+        const Range<type, DataType> rng(m_cont.get());
+        visitor(rng);
+    }
+
+    template<Type type, typename DataType, typename Visitor>
+    void visitRange(Visitor&, std::false_type) const{
+        throw ContainerException();
+    }
+
+    template<typename DataType>
+    bool sameRange(const Capability& o, std::true_type) const{
+        auto a = m_cont.lock<Detail::RangeData<DataType> >();
+        auto b = o.m_cont.lock<Detail::RangeData<DataType> >();
+        return DataType(a->m_minValue) == DataType(b->m_minValue) &&
+                DataType(a->m_maxValue) == DataType(b->m_maxValue) &&
+                DataType(a->m_stepSize) == DataType(b->m_stepSize) &&
+                DataType(a->m_defValue) == DataType(b->m_defValue) &&
+                DataType(a->m_currValue) == DataType(b->m_currValue);
+    }
+
+    template<typename DataType>
+    bool sameRange(const Capability& o, std::false_type) const{
+        // ranges of non-numeric types are invalid, compare at least the bytes
+        return sameData(o);
+    }
+
+    /// Whether the current container can be overwritten by a container
+    /// of the supplied type and size.
+    /// Containers holding handles are never reused, the handles must be freed.
+    template<typename DataType>
+    bool reusable(ConType conType, Type type, UInt32 size) const{
+        if (!m_cont || m_conType != conType || type == Type::Handle || itemType() != type){
+            return false;
+        }
+
+        UInt32 current;
+        switch (conType){
+            case ConType::Array: {
+                auto data = m_cont.lock<Detail::ArrayData<DataType> >();
+                current = sizeof(Detail::ArrayData<DataType>) - sizeof(DataType) + data->m_numItems * sizeof(DataType);
+                break;
+            }
+
+            case ConType::Enumeration: {
+                auto data = m_cont.lock<Detail::EnumerationData<DataType> >();
+                current = sizeof(Detail::EnumerationData<DataType>) - sizeof(DataType) + data->m_numItems * sizeof(DataType);
+                break;
+            }
+
+            default:
+                // fixed size for the item type
+                return true;
+        }
+
+        return size <= Detail::capacity(m_cont.get(), current);
+    }
+
     /// \throw DataException
     /// \throw ContainerException
     /// \throw ItemTypeException
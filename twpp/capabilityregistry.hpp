@@ -0,0 +1,283 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_CAPABILITYREGISTRY_HPP
+#define TWPP_DETAIL_FILE_CAPABILITYREGISTRY_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// Capability dispatch table for data sources.
+/// Standard capabilities are dispatched through a flat array indexed by CapType,
+/// custom capabilities through a small open-addressed hash table.
+/// Handles QuerySupport and SupportedCaps automatically, and checks
+/// whether a message is supported before calling a handler.
+/// All storage is inline, registering and dispatching never allocates.
+/// \tparam Derived Data source class.
+/// \tparam maxCaps Maximal number of registered capabilities.
+template<typename Derived, UInt16 maxCaps = 128>
+class CapabilityRegistry {
+
+    static_assert(maxCaps > 0 && maxCaps < 0x8000, "maxCaps must be in range [1, 32767]");
+
+public:
+    /// Capability handler.
+    /// Captureless lambdas convert to this type, see `member` for member functions.
+    typedef Result (*Handler)(Derived& source, Msg msg, Capability& data);
+
+    /// Adapts member function of the data source to Handler.
+    /// Usage: `registry.add(cap, support, &Registry::template member<&MySource::myCap>)`
+    template<Result (Derived::*func)(Msg, Capability&)>
+    static Result member(Derived& source, Msg msg, Capability& data){
+        return (source.*func)(msg, data);
+    }
+
+    /// Creates a registry handling only SupportedCaps.
+    CapabilityRegistry() noexcept{
+        clear();
+    }
+
+    /// Registers or replaces capability handler.
+    /// SupportedCaps is handled automatically unless a handler is registered for it.
+    /// \param cap Capability type.
+    /// \param support Supported operations, QuerySupport is always supported.
+    /// \param handler Capability handler.
+    /// \return False if the registry is full.
+    bool add(CapType cap, MsgSupport support, Handler handler) noexcept{
+        auto slot = find(cap);
+        if (slot){
+            m_entries[*slot - 1].m_support = support;
+            m_entries[*slot - 1].m_handler = handler;
+            return true;
+        }
+
+        if (m_size == maxCaps){
+            return false;
+        }
+
+        auto newSlot = insertSlot(cap);
+        if (!newSlot){
+            return false;
+        }
+
+        Entry& e = m_entries[m_size];
+        e.m_cap = cap;
+        e.m_support = support;
+        e.m_handler = handler;
+        m_size++;
+        *newSlot = m_size;
+        return true;
+    }
+
+    /// Removes all capabilities except the automatic SupportedCaps.
+    void clear() noexcept{
+        m_size = 0;
+        m_standard.fill(0);
+        m_custom.fill(0);
+        add(CapType::SupportedCaps, msgSupportGetAll, nullptr);
+    }
+
+    /// Whether the capability is registered.
+    bool contains(CapType cap) const noexcept{
+        return find(cap) != nullptr;
+    }
+
+    /// Operations supported by the capability, empty if not registered.
+    MsgSupport support(CapType cap) const noexcept{
+        auto slot = find(cap);
+        return slot ? m_entries[*slot - 1].m_support : msgSupportEmpty;
+    }
+
+    /// Number of registered capabilities, including SupportedCaps.
+    UInt16 size() const noexcept{
+        return m_size;
+    }
+
+    /// Registered capability at the supplied index, in order of registration.
+    CapType at(UInt16 index) const noexcept{
+        return m_entries[index].m_cap;
+    }
+
+    /// Dispatches capability operation.
+    /// Use from `SourceFromThis::capability` or the specific capability methods.
+    /// ResetAll is not dispatched, see `resetAll`.
+    Result dispatch(Derived& source, Msg msg, Capability& data) const{
+        auto slot = find(data.type());
+        if (!slot){
+            if (msg == Msg::QuerySupport){
+                data.assignOneValue(msgSupportEmpty);
+                return {};
+            }
+
+            return {ReturnCode::Failure, ConditionCode::CapUnsupported};
+        }
+
+        const Entry& e = m_entries[*slot - 1];
+        if (msg == Msg::QuerySupport){
+            data.assignOneValue(e.m_support);
+            return {};
+        }
+
+        if ((e.m_support & toSupport(msg)) == msgSupportEmpty){
+            return {ReturnCode::Failure, ConditionCode::CapBadOperation};
+        }
+
+        if (!e.m_handler){
+            return supportedCaps(data);
+        }
+
+        return e.m_handler(source, msg, data);
+    }
+
+    /// Resets all capabilities that support Reset.
+    /// Stops at the first failure.
+    Result resetAll(Derived& source) const{
+        for (UInt16 i = 0; i < m_size; i++){
+            const Entry& e = m_entries[i];
+            if (e.m_handler && (e.m_support & MsgSupport::Reset) != msgSupportEmpty){
+                Capability cap(e.m_cap);
+                auto rc = e.m_handler(source, Msg::Reset, cap);
+                if (!success(rc)){
+                    return rc;
+                }
+            }
+        }
+
+        return {};
+    }
+
+private:
+    struct Entry {
+        CapType m_cap;
+        MsgSupport m_support;
+        Handler m_handler;
+    };
+
+    // standard capabilities occupy pages 0x00, 0x01, 0x10, 0x11 and 0x12
+    static constexpr const UInt32 standardPages = 5;
+
+    static constexpr UInt32 customSlotsFor(UInt32 slots) noexcept{
+        return slots >= 2u * maxCaps ? slots : customSlotsFor(slots * 2);
+    }
+
+    static constexpr const UInt32 customSlots = customSlotsFor(16);
+
+    static int standardPage(UInt16 value) noexcept{
+        switch (value >> 8){
+            case 0x00: return 0;
+            case 0x01: return 1;
+            case 0x10: return 2;
+            case 0x11: return 3;
+            case 0x12: return 4;
+            default: return -1;
+        }
+    }
+
+    static UInt32 customHash(UInt16 value) noexcept{
+        return (static_cast<UInt32>(value) * 2654435761u) & (customSlots - 1);
+    }
+
+    static MsgSupport toSupport(Msg msg) noexcept{
+        switch (msg){
+            case Msg::Get: return MsgSupport::Get;
+            case Msg::Set: return MsgSupport::Set;
+            case Msg::GetDefault: return MsgSupport::GetDefault;
+            case Msg::GetCurrent: return MsgSupport::GetCurrent;
+            case Msg::Reset: return MsgSupport::Reset;
+            case Msg::SetConstraint: return MsgSupport::SetConstraint;
+            case Msg::GetHelp: return MsgSupport::GetHelp;
+            case Msg::GetLabel: return MsgSupport::GetLabel;
+            case Msg::GetLabelEnum: return MsgSupport::GetLabelEnum;
+            default: return msgSupportEmpty;
+        }
+    }
+
+    /// Slot holding entry index + 1 of the capability, nullptr if not registered.
+    const UInt16* find(CapType cap) const noexcept{
+        auto value = static_cast<UInt16>(cap);
+        auto page = standardPage(value);
+        if (page >= 0){
+            auto& slot = m_standard[static_cast<UInt32>(page) * 256 + (value & 0xFF)];
+            return slot ? &slot : nullptr;
+        }
+
+        for (UInt32 i = customHash(value), n = 0; n < customSlots; i = (i + 1) & (customSlots - 1), n++){
+            auto& slot = m_custom[i];
+            if (!slot){
+                return nullptr;
+            }
+
+            if (m_entries[slot - 1].m_cap == cap){
+                return &slot;
+            }
+        }
+
+        return nullptr;
+    }
+
+    UInt16* find(CapType cap) noexcept{
+        return const_cast<UInt16*>(static_cast<const CapabilityRegistry*>(this)->find(cap));
+    }
+
+    /// Empty slot for a capability that is not registered yet.
+    UInt16* insertSlot(CapType cap) noexcept{
+        auto value = static_cast<UInt16>(cap);
+        auto page = standardPage(value);
+        if (page >= 0){
+            return &m_standard[static_cast<UInt32>(page) * 256 + (value & 0xFF)];
+        }
+
+        for (UInt32 i = customHash(value), n = 0; n < customSlots; i = (i + 1) & (customSlots - 1), n++){
+            if (!m_custom[i]){
+                return &m_custom[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    Result supportedCaps(Capability& data) const{
+        data = Capability::createArray<CapType::SupportedCaps>(m_size);
+        auto arr = data.array<CapType::SupportedCaps>();
+        for (UInt16 i = 0; i < m_size; i++){
+            arr[i] = m_entries[i].m_cap;
+        }
+
+        return {};
+    }
+
+    std::array<Entry, maxCaps> m_entries;
+    std::array<UInt16, standardPages * 256> m_standard;
+    std::array<UInt16, customSlots> m_custom;
+    UInt16 m_size;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_CAPABILITYREGISTRY_HPP
+
@@ -0,0 +1,801 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_CONSTRAINTS_HPP
+#define TWPP_DETAIL_FILE_CONSTRAINTS_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+/// Exact integer representation of constraint values.
+/// Numeric types use RangeMath, enumerations their underlying values.
+template<typename T, bool isEnum = std::is_enum<T>::value> // false
+struct ConstraintValue {
+    static Int64 toRaw(T value) noexcept{
+        return RangeMath<T>::toRaw(value);
+    }
+
+    static T fromRaw(Int64 raw) noexcept{
+        return RangeMath<T>::fromRaw(raw);
+    }
+};
+
+template<typename T>
+struct ConstraintValue<T, true> {
+    static Int64 toRaw(T value) noexcept{
+        return static_cast<Int64>(value);
+    }
+
+    static T fromRaw(Int64 raw) noexcept{
+        return static_cast<T>(raw);
+    }
+};
+
+template<>
+struct ConstraintValue<Bool, false> {
+    static Int64 toRaw(Bool value) noexcept{
+        return value ? 1 : 0;
+    }
+
+    static Bool fromRaw(Int64 raw) noexcept{
+        return raw != 0;
+    }
+};
+
+template<typename T>
+static inline Int64 constraintRaw(T value) noexcept{
+    return ConstraintValue<T>::toRaw(value);
+}
+
+static inline Int64 gcd(Int64 a, Int64 b) noexcept{
+    while (b != 0){
+        auto t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+/// `a * b mod m` without overflow, `a` and `b` must be less than `m`, `m` at most 2^62.
+static inline Int64 mulMod(Int64 a, Int64 b, Int64 m) noexcept{
+    Int64 ret = 0;
+    for ( ; b > 0; b >>= 1){
+        if (b & 1){
+            ret = (ret + a) % m;
+        }
+
+        a = (a * 2) % m;
+    }
+
+    return ret;
+}
+
+/// Inverse of `a` modulo `m`, `a` and `m` must be coprime.
+static inline Int64 inverseMod(Int64 a, Int64 m) noexcept{
+    Int64 r0 = m, r1 = a % m;
+    Int64 t0 = 0, t1 = 1;
+    while (r1 != 0){
+        auto q = r0 / r1;
+        auto r = r0 - q * r1;
+        r0 = r1;
+        r1 = r;
+
+        auto t = t0 - q * t1;
+        t0 = t1;
+        t1 = t;
+    }
+
+    return t0 < 0 ? t0 + m : t0;
+}
+
+}
+
+/// Set of allowed values of a numeric capability.
+/// Either everything, an explicit list of values, or a range with a step.
+/// Values are kept in their exact integer representation, Fix32 in 1/65536 units.
+class ValueSet {
+
+public:
+    /// Creates set allowing every value.
+    ValueSet() noexcept :
+        m_kind(Kind::All), m_min(0), m_max(0), m_step(0){}
+
+    /// Creates set allowing no value.
+    static ValueSet none(){
+        return rawValues({});
+    }
+
+    /// Creates set of the supplied values.
+    /// \throw std::bad_alloc
+    template<typename T>
+    static ValueSet values(std::initializer_list<T> values){
+        std::vector<Int64> raw;
+        raw.reserve(values.size());
+        for (const auto& val : values){
+            raw.push_back(Detail::constraintRaw(val));
+        }
+
+        return rawValues(std::move(raw));
+    }
+
+    /// Creates set of the supplied values in their integer representation.
+    /// \throw std::bad_alloc
+    static ValueSet rawValues(std::vector<Int64> values){
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+
+        ValueSet ret;
+        ret.m_kind = Kind::List;
+        ret.m_values = std::move(values);
+        return ret;
+    }
+
+    /// Creates set of values `min + N * step` not greater than `max`.
+    template<typename T>
+    static ValueSet range(T min, T max, T step) noexcept{
+        return rawRange(Detail::constraintRaw(min), Detail::constraintRaw(max), Detail::constraintRaw(step));
+    }
+
+    /// Creates range set from values in their integer representation.
+    static ValueSet rawRange(Int64 min, Int64 max, Int64 step) noexcept{
+        ValueSet ret;
+        ret.m_kind = Kind::Range;
+        ret.m_min = min;
+        ret.m_step = step > 0 ? step : 1;
+        ret.m_max = max >= min ? min + (max - min) / ret.m_step * ret.m_step : min - 1;
+        return ret;
+    }
+
+    /// Whether every value is allowed.
+    bool isAll() const noexcept{
+        return m_kind == Kind::All;
+    }
+
+    /// Whether the set is a range.
+    bool isRange() const noexcept{
+        return m_kind == Kind::Range;
+    }
+
+    /// Whether no value is allowed.
+    bool empty() const noexcept{
+        return m_kind == Kind::List ? m_values.empty() : (m_kind == Kind::Range && m_max < m_min);
+    }
+
+    /// Number of allowed values, zero for sets allowing everything.
+    /// Saturates at the largest UInt32 like Range::size.
+    UInt32 size() const noexcept{
+        switch (m_kind){
+            case Kind::List: return static_cast<UInt32>(m_values.size());
+            case Kind::Range:
+                return m_max < m_min ? 0 : static_cast<UInt32>(std::min<UInt64>(
+                    static_cast<UInt64>((m_max - m_min) / m_step) + 1, std::numeric_limits<UInt32>::max()));
+            default: return 0;
+        }
+    }
+
+    /// Whether the value is allowed.
+    bool contains(Int64 raw) const noexcept{
+        switch (m_kind){
+            case Kind::List:
+                return std::binary_search(m_values.begin(), m_values.end(), raw);
+
+            case Kind::Range:
+                return raw >= m_min && raw <= m_max && (raw - m_min) % m_step == 0;
+
+            default:
+                return true;
+        }
+    }
+
+    /// Value at the supplied index, in ascending order.
+    Int64 at(UInt32 index) const noexcept{
+        assert(m_kind != Kind::All && index < size());
+        return m_kind == Kind::List ? m_values[index] : m_min + index * m_step;
+    }
+
+    /// Index of the value, or `size()` if not allowed or past the saturated `size()`.
+    UInt32 indexOf(Int64 raw) const noexcept{
+        if (!contains(raw) || m_kind == Kind::All){
+            return size();
+        }
+
+        if (m_kind == Kind::List){
+            return static_cast<UInt32>(std::lower_bound(m_values.begin(), m_values.end(), raw) - m_values.begin());
+        }
+
+        auto index = (raw - m_min) / m_step;
+        return index < size() ? static_cast<UInt32>(index) : size();
+    }
+
+    /// Range minimum, valid for ranges.
+    Int64 min() const noexcept{
+        return m_min;
+    }
+
+    /// Range maximum, valid for ranges.
+    Int64 max() const noexcept{
+        return m_max;
+    }
+
+    /// Range step, valid for ranges.
+    Int64 step() const noexcept{
+        return m_step;
+    }
+
+    /// Values allowed by both sets.
+    /// Intersection of two ranges is a range with the least common multiple of their steps.
+    /// \throw std::bad_alloc
+    ValueSet intersect(const ValueSet& o) const{
+        if (o.m_kind == Kind::All){
+            return *this;
+        }
+
+        if (m_kind == Kind::All){
+            return o;
+        }
+
+        if (m_kind == Kind::List || o.m_kind == Kind::List){
+            const ValueSet& list = m_kind == Kind::List ? *this : o;
+            const ValueSet& other = m_kind == Kind::List ? o : *this;
+
+            ValueSet ret;
+            ret.m_kind = Kind::List;
+            for (auto val : list.m_values){
+                if (other.contains(val)){
+                    ret.m_values.push_back(val);
+                }
+            }
+
+            return ret;
+        }
+
+        // two ranges, common values are `x + N * lcm(step1, step2)`,
+        // `x` is the smallest solution of `x = min1 (mod step1)` and `x = min2 (mod step2)` not less than `min`
+        auto min = std::max(m_min, o.m_min);
+        auto max = std::min(m_max, o.m_max);
+        if (empty() || o.empty() || max < min){
+            return none();
+        }
+
+        // first item of this range not less than `min`, then skip `k` steps to match the other range
+        auto first = m_min + (min - m_min + m_step - 1) / m_step * m_step;
+        auto g = Detail::gcd(m_step, o.m_step);
+        auto diff = o.m_min - first;
+        if (first > max || diff % g != 0){
+            return none();
+        }
+
+        auto mod = o.m_step / g;
+        auto rem = (diff / g) % mod;
+        auto k = Detail::mulMod(rem < 0 ? rem + mod : rem, Detail::inverseMod(m_step / g % mod, mod), mod);
+        if (k > (max - first) / m_step){
+            return none();
+        }
+
+        auto x = first + k * m_step;
+        auto lcm = m_step / g <= std::numeric_limits<Int64>::max() / o.m_step ?
+                   m_step / g * o.m_step : max - x + 1; // only `x` fits
+        return rawRange(x, max, lcm);
+    }
+
+private:
+    enum class Kind : UInt8 {
+        All,
+        List,
+        Range
+    };
+
+    Kind m_kind;
+    Int64 m_min;
+    Int64 m_max;
+    Int64 m_step;
+    std::vector<Int64> m_values;
+
+};
+
+/// Constraint engine for numeric capabilities of a data source.
+/// Each capability has a set of values supported by the device,
+/// a set the application constrained it to using MSG_SETCONSTRAINT,
+/// and rules of other capabilities, e.g. `ICompression = Group4` allows only `IPixelType = BlackWhite`.
+///
+/// Allowed values are cached per capability and recomputed only when
+/// a capability they depend on changes. If the current value becomes
+/// disallowed, it is changed to the default or the first allowed value,
+/// and the change propagates further.
+class ConstraintEngine {
+
+public:
+    /// Engine statistics.
+    class Stats {
+
+    public:
+        constexpr Stats() noexcept :
+            m_evaluations(0), m_adjustments(0){}
+
+        constexpr Stats(UInt64 evaluations, UInt64 adjustments) noexcept :
+            m_evaluations(evaluations), m_adjustments(adjustments){}
+
+        /// Number of computations of allowed values.
+        constexpr UInt64 evaluations() const noexcept{
+            return m_evaluations;
+        }
+
+        /// Number of current values changed by constraints.
+        constexpr UInt64 adjustments() const noexcept{
+            return m_adjustments;
+        }
+
+    private:
+        UInt64 m_evaluations;
+        UInt64 m_adjustments;
+
+    };
+
+    /// Adds or replaces numeric capability.
+    /// \param cap Capability type.
+    /// \param twty Item type, integer types, Bool or Fix32.
+    /// \param def Default value in its integer representation, also the initial current value.
+    /// \param supported Values supported by the device.
+    /// \throw std::bad_alloc
+    void add(CapType cap, Type twty, Int64 def, ValueSet supported){
+        assert(twty == Type::Int8 || twty == Type::Int16 || twty == Type::Int32 ||
+               twty == Type::UInt8 || twty == Type::UInt16 || twty == Type::UInt32 ||
+               twty == Type::Bool || twty == Type::Fix32);
+
+        auto idx = node(cap);
+        if (idx == noNode){
+            idx = static_cast<UInt32>(m_nodes.size());
+            m_index.emplace(static_cast<UInt16>(cap), idx);
+            m_nodes.emplace_back();
+        }
+
+        auto& n = m_nodes[idx];
+        n.m_cap = cap;
+        n.m_twty = twty;
+        n.m_def = def;
+        n.m_curr = def;
+        n.m_supported = std::move(supported);
+        n.m_constraint = ValueSet();
+        n.m_dirty = true;
+        propagate(idx);
+    }
+
+    /// Adds or replaces numeric capability.
+    /// \tparam T Item type, may be an enumeration.
+    /// \throw std::bad_alloc
+    template<typename T>
+    void add(CapType cap, T def, ValueSet supported){
+        add(cap, Detail::Tytw<T>::twty, Detail::constraintRaw(def), std::move(supported));
+    }
+
+    /// Adds or replaces numeric capability.
+    /// \tparam cap Capability type. Data types are set accordingly.
+    /// \throw std::bad_alloc
+    template<CapType cap>
+    void add(typename Detail::Cap<cap>::DataType def, ValueSet supported){
+        add(cap, Detail::Cap<cap>::twty, Detail::constraintRaw(def), std::move(supported));
+    }
+
+    /// Adds rule: while `when` is equal to `value`, `then` is restricted to `allowed`.
+    /// Both capabilities must already be added.
+    /// \throw std::bad_alloc
+    void addRule(CapType when, Int64 value, CapType then, ValueSet allowed){
+        auto from = node(when);
+        auto to = node(then);
+        assert(from != noNode && to != noNode);
+
+        auto idx = static_cast<UInt32>(m_rules.size());
+        m_rules.push_back(Rule{from, to, value, std::move(allowed)});
+        m_nodes[from].m_out.push_back(idx);
+        m_nodes[to].m_in.push_back(idx);
+        m_nodes[to].m_dirty = true;
+        propagate(from);
+    }
+
+    /// Adds rule: while `when` is equal to `value`, `then` is restricted to `allowed`.
+    /// \throw std::bad_alloc
+    template<typename T>
+    void addRule(CapType when, T value, CapType then, ValueSet allowed){
+        addRule(when, Detail::constraintRaw(value), then, std::move(allowed));
+    }
+
+    /// Whether the capability is handled by this engine.
+    bool contains(CapType cap) const noexcept{
+        return node(cap) != noNode;
+    }
+
+    /// Values currently allowed for the capability.
+    /// \throw std::bad_alloc
+    const ValueSet& allowed(CapType cap){
+        auto idx = node(cap);
+        assert(idx != noNode);
+        return evaluate(idx);
+    }
+
+    /// Current value of the capability in its integer representation.
+    Int64 current(CapType cap) const noexcept{
+        auto idx = node(cap);
+        assert(idx != noNode);
+        return m_nodes[idx].m_curr;
+    }
+
+    /// Current value of the capability.
+    template<CapType cap>
+    typename Detail::Cap<cap>::DataType current() const noexcept{
+        return Detail::ConstraintValue<typename Detail::Cap<cap>::DataType>::fromRaw(current(cap));
+    }
+
+    /// Sets current value of the capability.
+    /// \return Whether the value is allowed and was set.
+    /// \throw std::bad_alloc
+    bool set(CapType cap, Int64 value){
+        auto idx = node(cap);
+        assert(idx != noNode);
+
+        if (!evaluate(idx).contains(value)){
+            return false;
+        }
+
+        if (m_nodes[idx].m_curr != value){
+            m_nodes[idx].m_curr = value;
+            propagate(idx);
+        }
+
+        return true;
+    }
+
+    /// Resets the capability to its default value and removes application constraint.
+    /// \throw std::bad_alloc
+    void reset(CapType cap){
+        auto idx = node(cap);
+        assert(idx != noNode);
+
+        auto& n = m_nodes[idx];
+        n.m_constraint = ValueSet();
+        n.m_dirty = true;
+        n.m_curr = n.m_def;
+        fixCurrent(idx);
+        propagate(idx);
+    }
+
+    /// Resets all capabilities.
+    /// \throw std::bad_alloc
+    void resetAll(){
+        for (auto& n : m_nodes){
+            n.m_constraint = ValueSet();
+            n.m_curr = n.m_def;
+            n.m_dirty = true;
+        }
+
+        for (UInt32 i = 0; i < m_nodes.size(); i++){
+            fixCurrent(i);
+        }
+
+        for (UInt32 i = 0; i < m_nodes.size(); i++){
+            propagate(i);
+        }
+    }
+
+    /// Handles capability message.
+    /// Supports Get, GetCurrent, GetDefault, Set, Reset and SetConstraint.
+    /// \param cc Condition code of the result.
+    /// \throw std::bad_alloc
+    ReturnCode handle(Msg msg, Capability& data, ConditionCode& cc){
+        cc = ConditionCode::Success;
+        auto idx = node(data.type());
+        if (idx == noNode){
+            cc = ConditionCode::CapUnsupported;
+            return ReturnCode::Failure;
+        }
+
+        try {
+            switch (m_nodes[idx].m_twty){
+                case Type::Int8: return handle<Type::Int8>(idx, msg, data, cc);
+                case Type::Int16: return handle<Type::Int16>(idx, msg, data, cc);
+                case Type::Int32: return handle<Type::Int32>(idx, msg, data, cc);
+                case Type::UInt8: return handle<Type::UInt8>(idx, msg, data, cc);
+                case Type::UInt16: return handle<Type::UInt16>(idx, msg, data, cc);
+                case Type::UInt32: return handle<Type::UInt32>(idx, msg, data, cc);
+                case Type::Bool: return handle<Type::Bool>(idx, msg, data, cc);
+                case Type::Fix32: return handle<Type::Fix32>(idx, msg, data, cc);
+                default: break;
+            }
+        } catch (const CapabilityException&){
+            // container or item type of the application data does not match
+        }
+
+        cc = ConditionCode::BadValue;
+        return ReturnCode::Failure;
+    }
+
+#if defined(TWPP_IS_DS)
+    /// Handles capability message.
+    /// Suitable as the body of a CapabilityRegistry handler.
+    /// \throw std::bad_alloc
+    Result handle(Msg msg, Capability& data){
+        ConditionCode cc;
+        auto rc = handle(msg, data, cc);
+        return {rc, cc};
+    }
+#endif
+
+    /// Engine statistics.
+    Stats stats() const noexcept{
+        return {m_evaluations, m_adjustments};
+    }
+
+private:
+    static constexpr const UInt32 noNode = 0xFFFFFFFF;
+
+    struct Rule {
+        UInt32 m_from;
+        UInt32 m_to;
+        Int64 m_value;
+        ValueSet m_allowed;
+    };
+
+    struct Node {
+        CapType m_cap;
+        Type m_twty;
+        bool m_dirty = true;
+        Int64 m_def;
+        Int64 m_curr;
+        ValueSet m_supported;
+        ValueSet m_constraint;
+        ValueSet m_allowed;
+        std::vector<UInt32> m_in;
+        std::vector<UInt32> m_out;
+    };
+
+    UInt32 node(CapType cap) const noexcept{
+        auto it = m_index.find(static_cast<UInt16>(cap));
+        return it != m_index.end() ? it->second : noNode;
+    }
+
+    const ValueSet& evaluate(UInt32 idx){
+        auto& n = m_nodes[idx];
+        if (n.m_dirty){
+            auto allowed = n.m_supported.intersect(n.m_constraint);
+            for (auto r : n.m_in){
+                const auto& rule = m_rules[r];
+                if (m_nodes[rule.m_from].m_curr == rule.m_value){
+                    allowed = allowed.intersect(rule.m_allowed);
+                }
+            }
+
+            n.m_allowed = std::move(allowed);
+            n.m_dirty = false;
+            m_evaluations++;
+        }
+
+        return n.m_allowed;
+    }
+
+    /// Moves current value into the allowed set.
+    /// \return Whether the value changed.
+    bool fixCurrent(UInt32 idx){
+        const auto& allowed = evaluate(idx);
+        auto& n = m_nodes[idx];
+        if (allowed.contains(n.m_curr) || allowed.empty() || allowed.isAll()){
+            return false;
+        }
+
+        n.m_curr = allowed.contains(n.m_def) ? n.m_def : allowed.at(0);
+        m_adjustments++;
+        return true;
+    }
+
+    /// Re-evaluates capabilities depending on the changed one.
+    void propagate(UInt32 changed){
+        std::vector<UInt32> pending{changed};
+        // every capability may be adjusted a few times, stop cyclic rules eventually
+        std::size_t budget = 4 * m_nodes.size() + m_rules.size();
+        while (!pending.empty() && budget-- != 0){
+            auto idx = pending.back();
+            pending.pop_back();
+
+            // mark all first, several rules usually share the same target
+            const auto& out = m_nodes[idx].m_out;
+            for (auto r : out){
+                m_nodes[m_rules[r].m_to].m_dirty = true;
+            }
+
+            for (auto r : out){
+                auto to = m_rules[r].m_to;
+                if (fixCurrent(to)){
+                    pending.push_back(to);
+                }
+            }
+        }
+    }
+
+    template<Type type>
+    ReturnCode handle(UInt32 idx, Msg msg, Capability& data, ConditionCode& cc){
+        typedef typename Detail::Twty<type>::Type DataType;
+        typedef Detail::ConstraintValue<DataType> Value;
+
+        auto& n = m_nodes[idx];
+        switch (msg){
+            case Msg::Get: {
+                const auto& allowed = evaluate(idx);
+                if (allowed.isAll() || allowed.empty()){
+                    data = Capability::createOneValue<type, DataType>(n.m_cap, Value::fromRaw(n.m_curr));
+                } else if (allowed.isRange()){
+                    getRange<type, DataType>(n, allowed, data, std::integral_constant<bool, Detail::IsNumeric<DataType>::value>());
+                } else {
+                    getEnumeration<type, DataType>(n, allowed, data);
+                }
+
+                return ReturnCode::Success;
+            }
+
+            case Msg::GetCurrent:
+                data.assignOneValue<type, DataType>(Value::fromRaw(n.m_curr));
+                return ReturnCode::Success;
+
+            case Msg::GetDefault:
+                data.assignOneValue<type, DataType>(Value::fromRaw(n.m_def));
+                return ReturnCode::Success;
+
+            case Msg::Reset:
+                reset(n.m_cap);
+                data.assignOneValue<type, DataType>(Value::fromRaw(m_nodes[idx].m_curr));
+                return ReturnCode::Success;
+
+            case Msg::Set:
+                if (!set(n.m_cap, Value::toRaw(data.currentItem<type, DataType>()))){
+                    cc = ConditionCode::BadValue;
+                    return ReturnCode::Failure;
+                }
+
+                return ReturnCode::Success;
+
+            case Msg::SetConstraint:
+                return setConstraint<type>(idx, data, cc);
+
+            default:
+                cc = ConditionCode::CapBadOperation;
+                return ReturnCode::Failure;
+        }
+    }
+
+    template<Type type, typename DataType>
+    static void getEnumeration(const Node& n, const ValueSet& allowed, Capability& data){
+        typedef Detail::ConstraintValue<DataType> Value;
+
+        auto size = allowed.size();
+        auto defIdx = allowed.indexOf(n.m_def);
+        data = Capability::createEnumeration<type, DataType>(n.m_cap, size,
+                    allowed.indexOf(n.m_curr), defIdx != size ? defIdx : 0);
+
+        auto enm = data.enumeration<type, DataType>();
+        for (UInt32 i = 0; i < size; i++){
+            enm[i] = Value::fromRaw(allowed.at(i));
+        }
+    }
+
+    template<Type type, typename DataType>
+    static void getRange(const Node& n, const ValueSet& allowed, Capability& data, std::true_type){
+        typedef Detail::ConstraintValue<DataType> Value;
+
+        data = Capability::createRange<type, DataType>(n.m_cap,
+                    Value::fromRaw(allowed.min()), Value::fromRaw(allowed.max()), Value::fromRaw(allowed.step()),
+                    Value::fromRaw(n.m_curr), Value::fromRaw(n.m_def));
+    }
+
+    template<Type type, typename DataType>
+    static void getRange(const Node& n, const ValueSet& allowed, Capability& data, std::false_type){
+        // no ranges of non-numeric types
+        getEnumeration<type, DataType>(n, allowed, data);
+    }
+
+    template<Type type, typename DataType>
+    static bool constraintRange(Capability& data, ValueSet& out, std::true_type){
+        typedef Detail::ConstraintValue<DataType> Value;
+
+        auto rng = data.range<type, DataType>();
+        out = ValueSet::rawRange(Value::toRaw(rng.minValue()), Value::toRaw(rng.maxValue()), Value::toRaw(rng.stepSize()));
+        return true;
+    }
+
+    template<Type type, typename DataType>
+    static bool constraintRange(Capability&, ValueSet&, std::false_type){
+        return false;
+    }
+
+    template<Type type>
+    ReturnCode setConstraint(UInt32 idx, Capability& data, ConditionCode& cc){
+        typedef typename Detail::Twty<type>::Type DataType;
+        typedef Detail::ConstraintValue<DataType> Value;
+
+        ValueSet constraint;
+        switch (data.container()){
+            case ConType::Range:
+                if (!constraintRange<type, DataType>(data, constraint,
+                            std::integral_constant<bool, Detail::IsNumeric<DataType>::value>())){
+                    cc = ConditionCode::BadValue;
+                    return ReturnCode::Failure;
+                }
+
+                break;
+
+            case ConType::OneValue:
+            case ConType::Array:
+            case ConType::Enumeration: {
+                std::vector<Int64> values;
+                for (auto val : data.data<type, DataType>()){
+                    values.push_back(Value::toRaw(val));
+                }
+
+                constraint = ValueSet::rawValues(std::move(values));
+                break;
+            }
+
+            default:
+                cc = ConditionCode::BadValue;
+                return ReturnCode::Failure;
+        }
+
+        auto& n = m_nodes[idx];
+        if (n.m_supported.intersect(constraint).empty()){
+            cc = ConditionCode::BadValue;
+            return ReturnCode::Failure;
+        }
+
+        n.m_constraint = std::move(constraint);
+        n.m_dirty = true;
+
+        auto rc = ReturnCode::Success;
+        if (data.container() != ConType::Array){
+            auto requested = Value::toRaw(data.currentItem<type, DataType>());
+            if (evaluate(idx).contains(requested)){
+                n.m_curr = requested;
+            } else {
+                rc = ReturnCode::CheckStatus;
+            }
+        }
+
+        fixCurrent(idx);
+        propagate(idx);
+        return rc;
+    }
+
+    std::vector<Node> m_nodes;
+    std::vector<Rule> m_rules;
+    std::unordered_map<UInt16, UInt32> m_index;
+    UInt64 m_evaluations = 0;
+    UInt64 m_adjustments = 0;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_CONSTRAINTS_HPP
+
@@ -31,10 +31,20 @@ SOFTWARE.
 
 namespace Twpp {
 
+class CustomData;
+
+namespace Detail {
+
+static Handle customDataHandle(const CustomData& data) noexcept;
+
+}
+
 TWPP_DETAIL_PACK_BEGIN
 /// Structure for sending custom data to source or application.
 class CustomData {
 
+    friend Handle Detail::customDataHandle(const CustomData& data) noexcept;
+
 public:
     template <typename T>
     using Data = typename Detail::Lock<T>;
@@ -51,7 +61,7 @@ public:
     /// Locks and returns pointer to custom data memory.
     template<typename T = void>
     Data<T> lock() const noexcept{
-        return Data<T>(m_handle);
+        return Data<T>(m_handle.get());
     }
 
     /// The size of contained memory block.
@@ -66,6 +76,14 @@ private:
 };
 TWPP_DETAIL_PACK_END
 
+namespace Detail {
+
+static inline Handle customDataHandle(const CustomData& data) noexcept{
+    return data.m_handle.get();
+}
+
+}
+
 }
 
 #endif // TWPP_DETAIL_FILE_CUSTOMDATA_HPP
@@ -212,13 +212,9 @@ protected:
 
     /// Whether there exists an enabled source.
     static bool hasEnabled() noexcept{
-        for (auto& src : g_sources){
-            if (src.inState(DsState::Enabled, DsState::Xferring)){
-                return true;
-            }
-        }
-
-        return false;
+        return g_sources.any([](const Derived& src){
+            return src.inState(DsState::Enabled, DsState::Xferring);
+        });
     }
 
     /// Source identity.
@@ -1995,8 +1991,16 @@ private:
                     return callCapability(*origin, dg, dat, msg, data);
                 }
 
-                if (dat == Dat::ImageNativeXfer){
-                    return callImageNativeXfer(*origin, dg, dat, msg, data);
+                if (dat == Dat::ImageNativeXfer || dat == Dat::AudioNativeXfer){
+                    return callNativeXfer(*origin, dg, dat, msg, data);
+                }
+
+                if (dat == Dat::CustomData){
+                    return callCustomData(*origin, dg, dat, msg, data);
+                }
+
+                if (dat == Dat::ExtImageInfo){
+                    return callExtImageInfo(*origin, dg, dat, msg, data);
                 }
             }
 
@@ -2019,16 +2023,47 @@ private:
         Detail::DoNotFreeHandle doNotFree(cap.m_cont);
         Detail::unused(doNotFree);
 
-        return call(origin, dg, dat, msg, data);
+        auto rc = call(origin, dg, dat, msg, data);
+
+        // the container now belongs to the APP, never recycle it
+        Detail::disown(cap.m_cont);
+        return rc;
     }
 
-    Result callImageNativeXfer(const Identity& origin, DataGroup dg, Dat dat, Msg msg, void* data){
+    Result callNativeXfer(const Identity& origin, DataGroup dg, Dat dat, Msg msg, void* data){
         // same case as capability - make sure incoming handle is not freed
         Handle& handle = *static_cast<Handle*>(data);
         Detail::DoNotFreeHandle doNotFree(handle);
         Detail::unused(doNotFree);
 
-        return call(origin, dg, dat, msg, data);
+        auto rc = call(origin, dg, dat, msg, data);
+
+        Detail::disown(handle);
+        return rc;
+    }
+
+    Result callCustomData(const Identity& origin, DataGroup dg, Dat dat, Msg msg, void* data){
+        auto rc = call(origin, dg, dat, msg, data);
+
+        // the APP frees custom data it got from the source
+        if (msg == Msg::Get){
+            Detail::disown(Detail::customDataHandle(*static_cast<CustomData*>(data)));
+        }
+
+        return rc;
+    }
+
+    Result callExtImageInfo(const Identity& origin, DataGroup dg, Dat dat, Msg msg, void* data){
+        auto rc = call(origin, dg, dat, msg, data);
+
+        // the APP frees item handles of all entries, even after a failure
+        if (Detail::tracksHandles()){
+            for (auto& info : reinterpret_cast<ExtImageInfo&>(data)){
+                Detail::forgetInfo(info);
+            }
+        }
+
+        return rc;
     }
 
     Identity m_srcId;
@@ -2037,16 +2072,11 @@ private:
     DsState m_state;
 
 
-    static typename std::list<Derived>::iterator find(Identity* origin) noexcept{
-        if (origin){
-            for (auto it = g_sources.begin(); it != g_sources.end(); ++it){
-                if (it->m_appId.id() == origin->id()){
-                    return it;
-                }
-            }
-        }
+    typedef Detail::SessionTable<Derived, Identity::Id> Sources;
 
-        return g_sources.end();
+    /// Slot of the source opened by the application, or Sources::npos.
+    static UInt32 find(Identity* origin) noexcept{
+        return origin ? g_sources.find(origin->id()) : Sources::npos;
     }
 
     static void resetDsm(){
@@ -2057,7 +2087,7 @@ private:
 #endif
     }
 
-    static Result staticCall(typename std::list<Derived>::iterator src, Identity* origin,
+    static Result staticCall(UInt32 slot, Identity* origin,
                                  DataGroup dg, Dat dat, Msg msg, void* data){
 
 #if defined(TWPP_DETAIL_OS_WIN32)
@@ -2074,18 +2104,21 @@ private:
             return bummer();
         }
 
-        auto rc = src->callRoot(origin, dg, dat, msg, data);
-        src->m_lastStatus = rc.status();
+        auto& src = g_sources.at(slot);
+        auto rc = src.callRoot(origin, dg, dat, msg, data);
+        src.m_lastStatus = rc.status();
 
         if (dg == DataGroup::Control && dat == Dat::Identity && (
                 (msg == Msg::CloseDs && Twpp::success(rc)) ||
                 (msg == Msg::OpenDs && !Twpp::success(rc))
             )
         ){
-            g_sources.erase(src);
+            g_sources.erase(slot);
             if (g_sources.empty()){
                 resetDsm();
             }
+        } else if (dg == DataGroup::Control && dat == Dat::Identity && msg == Msg::OpenDs){
+            g_sources.bind(slot, src.m_appId.id());
         }
 
         return rc;
@@ -2144,8 +2177,7 @@ private:
                     }
 
                     case Msg::OpenDs: {
-                        g_sources.emplace_back();
-                        return staticCall(--g_sources.end(), origin, dg, dat, msg, data);
+                        return staticCall(g_sources.emplace(), origin, dg, dat, msg, data);
                     }
 
                     case Msg::CloseDs:
@@ -2177,9 +2209,26 @@ private:
 public:
     /// TWAIN entry, do not call from data source.
     static ReturnCode entry(Identity* origin, DataGroup dg, Dat dat, Msg msg, void* data) noexcept{
+#if defined(TWPP_TRIPLET_STATS)
+        if (dg == DataGroup::Control && dat == TripletStats::dat()){
+            return tripletStats(msg, data);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto rc = dispatch(origin, dg, dat, msg, data);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        Detail::TripletStatsData<void>::record(dg, dat, msg, rc, static_cast<UInt64>(ns));
+        return rc;
+#else
+        return dispatch(origin, dg, dat, msg, data);
+#endif
+    }
+
+private:
+    static ReturnCode dispatch(Identity* origin, DataGroup dg, Dat dat, Msg msg, void* data) noexcept{
         auto src = find(origin);
         try {
-            auto rc = src == g_sources.end() ?
+            auto rc = src == Sources::npos ?
                         staticControl(origin, dg, dat, msg, data) :
                         staticCall(src, origin, dg, dat, msg, data);
 
@@ -2197,8 +2246,25 @@ public:
         }
     }
 
-private:
-    static std::list<Derived> g_sources;
+#if defined(TWPP_TRIPLET_STATS)
+    static ReturnCode tripletStats(Msg msg, void* data) noexcept{
+        if (!data){
+            g_lastStatus = ConditionCode::BadValue;
+            return ReturnCode::Failure;
+        }
+
+        if (msg != Msg::Get && msg != Msg::Reset){
+            g_lastStatus = ConditionCode::BadProtocol;
+            return ReturnCode::Failure;
+        }
+
+        Detail::TripletStatsData<void>::snapshot(*static_cast<TripletStats*>(data), msg == Msg::Reset);
+        g_lastStatus = ConditionCode::Success;
+        return ReturnCode::Success;
+    }
+#endif
+
+    static Sources g_sources;
     static Detail::DsmEntry g_entry;
     static Status g_lastStatus;
 
@@ -2209,7 +2275,7 @@ private:
 };
 
 template<typename Derived, bool proc>
-std::list<Derived> SourceFromThis<Derived, proc>::g_sources;
+typename SourceFromThis<Derived, proc>::Sources SourceFromThis<Derived, proc>::g_sources;
 
 template<typename Derived, bool proc>
 Detail::DsmEntry SourceFromThis<Derived, proc>::g_entry;
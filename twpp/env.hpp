@@ -288,6 +288,7 @@ static void postDummy() noexcept{
 extern "C" {
 #   include <dlfcn.h>
 #   include <endian.h>
+#   include <sys/mman.h>
 }
 #   if __BYTE_ORDER == __LITTLE_ENDIAN
 #       define TWPP_DETAIL_ENDIAN_LITTLE
@@ -370,6 +371,24 @@ static inline void unload(Handle h) noexcept{
 #endif
 
 
+// ================
+// instruction sets
+
+// SSE2, always available on x64
+// define TWPP_NO_SIMD to use scalar code only
+#if !defined(TWPP_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#   define TWPP_DETAIL_SIMD_SSE2 1
+#   include <emmintrin.h>
+#endif
+
+
+// ================
+// diagnostics
+
+// define TWPP_TRIPLET_STATS in a data source to count calls and measure latency of each triplet,
+// applications read the statistics through custom data type TripletStats::dat()
+
+
 #if (!defined(_MSC_VER) && __cplusplus < 201103L) || (defined(_MSC_VER) && _MSC_VER < 1900) // msvc2015
 #   error "C++11 or later is required"
 #endif
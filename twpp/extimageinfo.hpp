@@ -135,6 +135,8 @@ static Handle handleItem(Info& info) noexcept;
 
 static void deleteInfo(Info& info) noexcept;
 
+static void forgetInfo(Info& info) noexcept;
+
 }
 
 TWPP_DETAIL_PACK_BEGIN
@@ -144,6 +146,7 @@ class Info {
     friend class ExtImageInfo;
     friend Handle Detail::handleItem(Info& info) noexcept;
     friend void Detail::deleteInfo(Info& info) noexcept;
+    friend void Detail::forgetInfo(Info& info) noexcept;
     static constexpr const UInt32 DATA_HANDLE_THRESHOLD = sizeof(UIntPtr);  // NOTE: specification says 4 bytes, yet pointer size makes more sense
 
 public:
@@ -393,6 +396,24 @@ static inline void deleteInfo(Info& info) noexcept{
     }
 }
 
+/// Drops bookkeeping of all handles of the entry, see `disown`,
+/// they are owned by the application once the source returns.
+static inline void forgetInfo(Info& info) noexcept{
+    bool big = isType(info.type()) && info.hasDataHandle();
+    bool handle = info.type() == Type::Handle;
+
+    if (big && handle){
+        Detail::Lock<Handle> lock(handleItem(info));
+        for (UInt16 i = 0; i < info.size(); i++){
+            Detail::disown(lock.data()[i]);
+        }
+    }
+
+    if (big || handle){
+        Detail::disown(handleItem(info));
+    }
+}
+
 struct ExtImageInfoData {
     UInt32 m_numInfos;
     Info m_infos[1];
@@ -34,19 +34,15 @@ namespace Twpp {
 namespace Detail {
 
 static constexpr inline Int32 floatToValue(float val){
-    return static_cast<Int32>(
-        (val >= 0.0f) ?
-        (val * 65536.0f + 0.5f) :
-        (val * 65536.0f - 0.5f)
-    );
+    return static_cast<Int32>(val * 65536.0f + (val >= 0.0f ? 0.5f : -0.5f));
 }
 
-static constexpr inline Int16 floatToWhole(float val){
-    return static_cast<Int16>(floatToValue(val) >> 16);
+static constexpr inline Int32 saturateInt32(Int64 val){
+    return val > 0x7FFFFFFF ? 0x7FFFFFFF : (val < -0x7FFFFFFF - 1 ? -0x7FFFFFFF - 1 : static_cast<Int32>(val));
 }
 
-static constexpr inline UInt16 floatToFrac(float val){
-    return static_cast<UInt16>(floatToValue(val) & 0xFFFF);
+static constexpr inline Int32 wrapInt32(UInt32 val){
+    return static_cast<Int32>(val);
 }
 
 }
@@ -54,22 +50,31 @@ static constexpr inline UInt16 floatToFrac(float val){
 TWPP_DETAIL_PACK_BEGIN
 /// TWAIN fixed point fractional type.
 /// The fractional part has resolution of 1/65536.
+/// Arithmetic is done on the 16.16 integer representation, see `raw`.
 class Fix32 {
 
+    struct RawTag {};
+
 public:
     /// Creates zero-initialized fixed type.
     constexpr Fix32() noexcept :
         m_whole(0), m_frac(0){}
 
     /// Creates fixed type from float at compile time if possible.
+    /// Rounds to the nearest representable value.
     constexpr Fix32(float value) noexcept :
-        m_whole(Detail::floatToWhole(value)), m_frac(Detail::floatToFrac(value)){}
+        Fix32(Detail::floatToValue(value), RawTag()){}
 
     /// Creates fixed type from whole and fractional parts.
     /// The fractional part has resolution of 1/65536.
     constexpr Fix32(Int16 whole, UInt16 frac) noexcept :
         m_whole(whole), m_frac(frac){}
 
+    /// Creates fixed type from its 16.16 integer representation.
+    static constexpr Fix32 fromRaw(Int32 raw) noexcept{
+        return Fix32(raw, RawTag());
+    }
+
 
     /// Whole part of this fixed type.
     constexpr Int16 whole() const noexcept{
@@ -93,75 +98,92 @@ public:
         m_frac = frac;
     }
 
+    /// The 16.16 integer representation, value multiplied by 65536.
+    constexpr Int32 raw() const noexcept{
+        return static_cast<Int32>(m_whole) * 65536 + m_frac;
+    }
+
     explicit constexpr operator float() const noexcept{
         return toFloat();
     }
 
     constexpr float toFloat() const noexcept{
-        return m_whole + m_frac / 65536.0f;
+        return static_cast<float>(raw()) * (1.0f / 65536.0f);
     }
 
     constexpr Fix32 operator-() const noexcept{
-        return -toFloat();
+        return fromRaw(Detail::wrapInt32(0u - static_cast<UInt32>(raw())));
     }
 
 private:
+    constexpr Fix32(Int32 raw, RawTag) noexcept :
+        m_whole(static_cast<Int16>(raw >> 16)), m_frac(static_cast<UInt16>(raw & 0xFFFF)){}
+
     Int16 m_whole;
     UInt16 m_frac;
 
 };
 TWPP_DETAIL_PACK_END
 
-namespace Detail {
-
-static inline constexpr Fix32 fix32AddHelper(Int32 frac, Int16 whole){
-    return frac < 65536 ? Fix32(whole, frac) : Fix32(whole + 1, frac - 65536);
-}
-
-static inline constexpr Fix32 fix32SubHelper(Int32 frac, Int16 whole){
-    return frac >= 0 ? Fix32(whole, frac) : Fix32(whole - 1, frac + 65536);
-}
-
-}
-
 static inline constexpr bool operator>(Fix32 a, Fix32 b) noexcept{
-    return a.whole() > b.whole() || (a.whole() == b.whole() && a.frac() > b.frac());
+    return a.raw() > b.raw();
 }
 
 static inline constexpr bool operator<(Fix32 a, Fix32 b) noexcept{
-    return a.whole() < b.whole() || (a.whole() == b.whole() && a.frac() < b.frac());
+    return a.raw() < b.raw();
 }
 
 static inline constexpr bool operator>=(Fix32 a, Fix32 b) noexcept{
-    return !(a < b);
+    return a.raw() >= b.raw();
 }
 
 static inline constexpr bool operator<=(Fix32 a, Fix32 b) noexcept{
-    return !(a > b);
+    return a.raw() <= b.raw();
 }
 
 static inline constexpr bool operator==(Fix32 a, Fix32 b) noexcept{
-    return a.whole() == b.whole() && a.frac() == b.frac();
+    return a.raw() == b.raw();
 }
 
 static inline constexpr bool operator!=(Fix32 a, Fix32 b) noexcept{
-    return !(a == b);
+    return a.raw() != b.raw();
 }
 
+/// Wraps around on overflow.
 static inline constexpr Fix32 operator+(Fix32 a, Fix32 b) noexcept{
-    return Detail::fix32AddHelper(static_cast<Int32>(a.frac()) + b.frac(), a.whole() + b.whole());
+    return Fix32::fromRaw(Detail::wrapInt32(static_cast<UInt32>(a.raw()) + static_cast<UInt32>(b.raw())));
 }
 
+/// Wraps around on overflow.
 static inline constexpr Fix32 operator-(Fix32 a, Fix32 b) noexcept{
-    return Detail::fix32SubHelper(static_cast<Int32>(a.frac()) - b.frac(), a.whole() - b.whole());
+    return Fix32::fromRaw(Detail::wrapInt32(static_cast<UInt32>(a.raw()) - static_cast<UInt32>(b.raw())));
 }
 
+namespace Detail {
+
+static constexpr inline Int64 fix32Product(Int64 product) noexcept{
+    // round half away from zero, same as division and `round`
+    return product >= 0 ? (product + 0x8000) >> 16 : -((-product + 0x8000) >> 16);
+}
+
+static constexpr inline Int64 fix32Quotient(Int64 num, Int64 den) noexcept{
+    // round half away from zero
+    return ((num < 0) == (den < 0) ? num + den / 2 : num - den / 2) / den;
+}
+
+}
+
+/// Exact product rounded to the nearest 1/65536, halves away from zero, saturates on overflow.
 static inline constexpr Fix32 operator*(Fix32 a, Fix32 b) noexcept{
-    return Fix32(static_cast<float>(a) * static_cast<float>(b));
+    return Fix32::fromRaw(Detail::saturateInt32(Detail::fix32Product(static_cast<Int64>(a.raw()) * b.raw())));
 }
 
-static inline constexpr Fix32 operator/(Fix32 a, Fix32 b) noexcept{ // wonder about zero b
-    return Fix32(static_cast<float>(a) / static_cast<float>(b));
+/// Exact quotient rounded to the nearest 1/65536, halves away from zero, saturates on overflow.
+/// Division by zero saturates according to the sign of `a`.
+static inline constexpr Fix32 operator/(Fix32 a, Fix32 b) noexcept{
+    return Fix32::fromRaw(b.raw() == 0 ?
+                              (a.raw() < 0 ? -0x7FFFFFFF - 1 : 0x7FFFFFFF) :
+                              Detail::saturateInt32(Detail::fix32Quotient(static_cast<Int64>(a.raw()) * 65536, b.raw())));
 }
 
 static inline Fix32& operator+=(Fix32& a, Fix32 b) noexcept{
@@ -176,10 +198,48 @@ static inline Fix32& operator*=(Fix32& a, Fix32 b) noexcept{
     return a = a * b;
 }
 
-static inline Fix32& operator/=(Fix32& a, Fix32 b) noexcept{ // wonder about zero b
+static inline Fix32& operator/=(Fix32& a, Fix32 b) noexcept{
     return a = a / b;
 }
 
+/// Rounds to the nearest whole number, halves away from zero.
+static inline constexpr Int32 round(Fix32 a) noexcept{
+    return a.raw() >= 0 ?
+                static_cast<Int32>((static_cast<Int64>(a.raw()) + 0x8000) >> 16) :
+                -static_cast<Int32>((-static_cast<Int64>(a.raw()) + 0x8000) >> 16);
+}
+
+// Bulk conversions.
+// Plain loops over independent elements, compilers vectorise them.
+
+/// Converts fixed values to floats.
+static inline void convert(const Fix32* in, float* out, std::size_t count) noexcept{
+    for (std::size_t i = 0; i < count; i++){
+        out[i] = static_cast<float>(static_cast<Int32>(in[i].whole()) * 65536 + in[i].frac()) * (1.0f / 65536.0f);
+    }
+}
+
+/// Converts floats to fixed values, rounding to the nearest representable value.
+static inline void convert(const float* in, Fix32* out, std::size_t count) noexcept{
+    for (std::size_t i = 0; i < count; i++){
+        out[i] = Fix32::fromRaw(Detail::floatToValue(in[i]));
+    }
+}
+
+/// Converts fixed values to their 16.16 integer representation.
+static inline void convert(const Fix32* in, Int32* out, std::size_t count) noexcept{
+    for (std::size_t i = 0; i < count; i++){
+        out[i] = static_cast<Int32>(in[i].whole()) * 65536 + in[i].frac();
+    }
+}
+
+/// Converts 16.16 integer representation to fixed values.
+static inline void convert(const Int32* in, Fix32* out, std::size_t count) noexcept{
+    for (std::size_t i = 0; i < count; i++){
+        out[i] = Fix32::fromRaw(in[i]);
+    }
+}
+
 namespace Literals {
 
 static inline constexpr Fix32 operator "" _fix(long double val) noexcept{
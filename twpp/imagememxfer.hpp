@@ -139,6 +139,16 @@ public:
         return m_memory;
     }
 
+    /// Non-owning view of uncompressed rows in this transfer.
+    ConstImageView imageView() const noexcept{
+        return m_memory.imageView(m_rows, m_bytesPerRow);
+    }
+
+    /// Non-owning view of uncompressed rows in this transfer.
+    ImageView imageView() noexcept{
+        return m_memory.imageView(m_rows, m_bytesPerRow);
+    }
+
 private:
     Compression m_compression;
     UInt32 m_bytesPerRow;
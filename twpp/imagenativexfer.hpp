@@ -77,6 +77,30 @@ public:
         return m_handle.lock<const typename std::decay<T>::type>();
     }
 
+    /// Non-owning view of image rows in this native transfer.
+    /// Layout of the rows depends on the native format, see `data`.
+    /// \param offset Offset of the first row, e.g. past BMP headers and palette.
+    /// \param rows Number of rows.
+    /// \param bytesPerRow Number of bytes in a single row, including padding.
+    /// \param bottomUp Whether the rows are stored bottom-up, as in BMP.
+    ConstImageView imageView(UInt32 offset, UInt32 rows, UInt32 bytesPerRow, bool bottomUp = false) const noexcept{
+        return ConstImageView(ConstImageView::Data(m_handle.get()),
+                              bottomUp && rows != 0 ? offset + (rows - 1) * bytesPerRow : offset,
+                              rows, bytesPerRow, bottomUp ? -static_cast<Int32>(bytesPerRow) : static_cast<Int32>(bytesPerRow));
+    }
+
+    /// Non-owning view of image rows in this native transfer.
+    /// Layout of the rows depends on the native format, see `data`.
+    /// \param offset Offset of the first row, e.g. past BMP headers and palette.
+    /// \param rows Number of rows.
+    /// \param bytesPerRow Number of bytes in a single row, including padding.
+    /// \param bottomUp Whether the rows are stored bottom-up, as in BMP.
+    ImageView imageView(UInt32 offset, UInt32 rows, UInt32 bytesPerRow, bool bottomUp = false) noexcept{
+        return ImageView(ImageView::Data(m_handle.get()),
+                         bottomUp && rows != 0 ? offset + (rows - 1) * bytesPerRow : offset,
+                         rows, bytesPerRow, bottomUp ? -static_cast<Int32>(bytesPerRow) : static_cast<Int32>(bytesPerRow));
+    }
+
     operator bool() const noexcept{
         return m_handle;
     }
@@ -0,0 +1,334 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#ifndef TWPP_DETAIL_FILE_ITEMSEARCH_HPP
+#define TWPP_DETAIL_FILE_ITEMSEARCH_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+/// Comparison key of capability items.
+/// The default implementation compares items using their own operators.
+template<typename T, bool isEnum = std::is_enum<T>::value, bool isIntegral = std::is_integral<T>::value> // false, false
+struct ItemKey {
+    typedef T Key;
+    static constexpr const bool vectorized = false;
+
+    static const Key& key(const T& item) noexcept{
+        return item;
+    }
+
+    static T fromKey(const Key& key) noexcept{
+        return key;
+    }
+};
+
+/// Integral items.
+template<typename T>
+struct ItemKey<T, false, true> {
+    typedef T Key;
+    static constexpr const bool vectorized = !std::is_same<T, bool>::value && sizeof(T) <= sizeof(UInt32);
+    static constexpr const bool swapHalves = false;
+
+    static Key key(T item) noexcept{
+        return item;
+    }
+
+    static T fromKey(Key key) noexcept{
+        return key;
+    }
+};
+
+/// Enumeration items, compared by their underlying values.
+template<typename T>
+struct ItemKey<T, true, false> {
+    typedef typename std::underlying_type<T>::type Key;
+    static constexpr const bool vectorized = sizeof(T) <= sizeof(UInt32);
+    static constexpr const bool swapHalves = false;
+
+    static Key key(T item) noexcept{
+        return static_cast<Key>(item);
+    }
+
+    static T fromKey(Key key) noexcept{
+        return static_cast<T>(key);
+    }
+};
+
+/// Fix32 items, compared by their 16.16 representation.
+/// In memory, the whole part precedes the fraction,
+/// halves of the loaded 32bit value must be swapped to get the ordering right.
+template<>
+struct ItemKey<Fix32, false, false> {
+    typedef Int32 Key;
+    static constexpr const bool vectorized = true;
+    static constexpr const bool swapHalves = true;
+
+    static Key key(Fix32 item) noexcept{
+        return item.raw();
+    }
+
+    static Fix32 fromKey(Key key) noexcept{
+        return Fix32::fromRaw(key);
+    }
+};
+
+/// Index of the first item equal to the value, or `count` if there is none.
+/// Plain loop, used for non-numeric items and short tails.
+template<typename T>
+UInt32 findItemScalar(const T* items, UInt32 count, const T& value) noexcept{
+    typedef ItemKey<T> K;
+
+    const auto& key = K::key(value);
+    for (UInt32 i = 0; i < count; i++){
+        if (K::key(items[i]) == key){
+            return i;
+        }
+    }
+
+    return count;
+}
+
+/// Smallest and largest item.
+/// Plain loop, used for non-numeric items and short containers.
+/// \return False if there are no items.
+template<typename T>
+bool minMaxItemsScalar(const T* items, UInt32 count, T& min, T& max) noexcept{
+    typedef ItemKey<T> K;
+
+    if (count == 0){
+        return false;
+    }
+
+    auto lo = K::key(items[0]);
+    auto hi = lo;
+    for (UInt32 i = 1; i < count; i++){
+        auto key = K::key(items[i]);
+        lo = key < lo ? key : lo;
+        hi = hi < key ? key : hi;
+    }
+
+    min = K::fromKey(lo);
+    max = K::fromKey(hi);
+    return true;
+}
+
+#if defined(TWPP_DETAIL_SIMD_SSE2)
+/// SSE2 operations on lanes of the supplied size in bytes.
+template<std::size_t size>
+struct SimdLanes;
+
+template<>
+struct SimdLanes<1> {
+    typedef UInt8 Bits;
+
+    static __m128i set1(Bits bits) noexcept{
+        return _mm_set1_epi8(static_cast<char>(bits));
+    }
+
+    static __m128i eq(__m128i a, __m128i b) noexcept{
+        return _mm_cmpeq_epi8(a, b);
+    }
+
+    static __m128i gt(__m128i a, __m128i b) noexcept{
+        return _mm_cmpgt_epi8(a, b);
+    }
+};
+
+template<>
+struct SimdLanes<2> {
+    typedef UInt16 Bits;
+
+    static __m128i set1(Bits bits) noexcept{
+        return _mm_set1_epi16(static_cast<short>(bits));
+    }
+
+    static __m128i eq(__m128i a, __m128i b) noexcept{
+        return _mm_cmpeq_epi16(a, b);
+    }
+
+    static __m128i gt(__m128i a, __m128i b) noexcept{
+        return _mm_cmpgt_epi16(a, b);
+    }
+};
+
+template<>
+struct SimdLanes<4> {
+    typedef UInt32 Bits;
+
+    static __m128i set1(Bits bits) noexcept{
+        return _mm_set1_epi32(static_cast<int>(bits));
+    }
+
+    static __m128i eq(__m128i a, __m128i b) noexcept{
+        return _mm_cmpeq_epi32(a, b);
+    }
+
+    static __m128i gt(__m128i a, __m128i b) noexcept{
+        return _mm_cmpgt_epi32(a, b);
+    }
+};
+
+template<typename T>
+UInt32 findItemSimd(const T* items, UInt32 count, const T& value) noexcept{
+    typedef SimdLanes<sizeof(T)> L;
+    static constexpr const UInt32 lanes = 16 / sizeof(T);
+
+    // equal items have equal bits, Fix32 included
+    typename L::Bits bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    auto needle = L::set1(bits);
+
+    UInt32 i = 0;
+    for (; i + lanes <= count; i += lanes){
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(items + i));
+        if (_mm_movemask_epi8(L::eq(block, needle)) != 0){
+            break;
+        }
+    }
+
+    // locate the item within the matching block, or search the tail
+    return i + findItemScalar(items + i, count - i, value);
+}
+
+template<typename T>
+void minMaxItemsSimd(const T* items, UInt32 count, T& min, T& max) noexcept{
+    typedef ItemKey<T> K;
+    typedef SimdLanes<sizeof(T)> L;
+    static constexpr const UInt32 lanes = 16 / sizeof(T);
+    assert(count >= lanes);
+
+    // SSE2 compares signed lanes only, flip sign bits of unsigned keys
+    auto bias = std::is_signed<typename K::Key>::value ?
+                _mm_setzero_si128() :
+                L::set1(static_cast<typename L::Bits>(1u << (8 * sizeof(T) - 1)));
+
+    auto load = [&](UInt32 i) -> __m128i {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(items + i));
+        if (K::swapHalves){
+            block = _mm_or_si128(_mm_slli_epi32(block, 16), _mm_srli_epi32(block, 16));
+        }
+
+        return _mm_xor_si128(block, bias);
+    };
+
+    auto select = [](__m128i mask, __m128i a, __m128i b) -> __m128i {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    };
+
+    auto lo = load(0);
+    auto hi = lo;
+    auto step = [&](__m128i block){
+        lo = select(L::gt(lo, block), block, lo);
+        hi = select(L::gt(block, hi), block, hi);
+    };
+
+    UInt32 i = lanes;
+    for (; i + lanes <= count; i += lanes){
+        step(load(i));
+    }
+
+    // the tail overlaps the last full block, which does not change the result
+    if (i < count){
+        step(load(count - lanes));
+    }
+
+    // undo the transformations and reduce the lanes
+    T lanesLo[lanes];
+    T lanesHi[lanes];
+    lo = _mm_xor_si128(lo, bias);
+    hi = _mm_xor_si128(hi, bias);
+    if (K::swapHalves){
+        lo = _mm_or_si128(_mm_slli_epi32(lo, 16), _mm_srli_epi32(lo, 16));
+        hi = _mm_or_si128(_mm_slli_epi32(hi, 16), _mm_srli_epi32(hi, 16));
+    }
+
+    std::memcpy(static_cast<void*>(lanesLo), &lo, sizeof(lanesLo));
+    std::memcpy(static_cast<void*>(lanesHi), &hi, sizeof(lanesHi));
+
+    T unused;
+    minMaxItemsScalar(lanesLo, lanes, min, unused);
+    minMaxItemsScalar(lanesHi, lanes, unused, max);
+}
+
+template<typename T>
+UInt32 findItem(const T* items, UInt32 count, const T& value, std::true_type) noexcept{
+    return findItemSimd(items, count, value);
+}
+
+template<typename T>
+bool minMaxItems(const T* items, UInt32 count, T& min, T& max, std::true_type) noexcept{
+    if (count < 16 / sizeof(T)){
+        return minMaxItemsScalar(items, count, min, max);
+    }
+
+    minMaxItemsSimd(items, count, min, max);
+    return true;
+}
+#endif
+
+template<typename T>
+UInt32 findItem(const T* items, UInt32 count, const T& value, std::false_type) noexcept{
+    return findItemScalar(items, count, value);
+}
+
+template<typename T>
+bool minMaxItems(const T* items, UInt32 count, T& min, T& max, std::false_type) noexcept{
+    return minMaxItemsScalar(items, count, min, max);
+}
+
+#if defined(TWPP_DETAIL_SIMD_SSE2)
+template<typename T>
+struct ItemSearchVectorized : std::integral_constant<bool, ItemKey<T>::vectorized> {};
+#else
+template<typename T>
+struct ItemSearchVectorized : std::false_type {};
+#endif
+
+/// Index of the first item equal to the value, or `count` if there is none.
+/// 8, 16 and 32bit integers, enumerations and Fix32 are compared using SIMD if available.
+template<typename T>
+UInt32 findItem(const T* items, UInt32 count, const T& value) noexcept{
+    return findItem(items, count, value, ItemSearchVectorized<T>());
+}
+
+/// Smallest and largest item.
+/// 8, 16 and 32bit integers, enumerations and Fix32 are compared using SIMD if available.
+/// \return False if there are no items.
+template<typename T>
+bool minMaxItems(const T* items, UInt32 count, T& min, T& max) noexcept{
+    return minMaxItems(items, count, min, max, ItemSearchVectorized<T>());
+}
+
+}
+
+}
+
+#endif // TWPP_DETAIL_FILE_ITEMSEARCH_HPP
@@ -155,6 +155,95 @@ public:
         return m_size;
     }
 
+    /// Non-owning view of the whole memory block.
+    ConstMemoryView view() const noexcept{
+        return ConstMemoryView(data(), 0, m_size);
+    }
+
+    /// Non-owning view of the whole memory block.
+    MemoryView view() noexcept{
+        return MemoryView(data(), 0, m_size);
+    }
+
+    /// Non-owning view of a part of the memory block.
+    /// \param offset Offset of the first byte.
+    /// \param size Number of bytes, clamped to the end of the memory block.
+    ConstMemoryView view(UInt32 offset, UInt32 size) const noexcept{
+        assert(offset <= m_size);
+        return ConstMemoryView(data(), offset, std::min(size, m_size - offset));
+    }
+
+    /// Non-owning view of a part of the memory block.
+    /// \param offset Offset of the first byte.
+    /// \param size Number of bytes, clamped to the end of the memory block.
+    MemoryView view(UInt32 offset, UInt32 size) noexcept{
+        assert(offset <= m_size);
+        return MemoryView(data(), offset, std::min(size, m_size - offset));
+    }
+
+    /// Non-owning view of top-down image rows stored in the memory block.
+    /// \param rows Number of rows.
+    /// \param bytesPerRow Number of bytes in a single row, including padding.
+    /// \param offset Offset of the first row.
+    ConstImageView imageView(UInt32 rows, UInt32 bytesPerRow, UInt32 offset = 0) const noexcept{
+        assert(static_cast<UInt64>(rows) * bytesPerRow + offset <= m_size);
+        return ConstImageView(data(), offset, rows, bytesPerRow, static_cast<Int32>(bytesPerRow));
+    }
+
+    /// Non-owning view of top-down image rows stored in the memory block.
+    /// \param rows Number of rows.
+    /// \param bytesPerRow Number of bytes in a single row, including padding.
+    /// \param offset Offset of the first row.
+    ImageView imageView(UInt32 rows, UInt32 bytesPerRow, UInt32 offset = 0) noexcept{
+        assert(static_cast<UInt64>(rows) * bytesPerRow + offset <= m_size);
+        return ImageView(data(), offset, rows, bytesPerRow, static_cast<Int32>(bytesPerRow));
+    }
+
+    /// Number of bytes the memory block can hold without reallocation.
+    UInt32 capacity() const noexcept{
+        return m_flags & Detail::Flags::Handle ?
+                    Detail::capacity(Handle(static_cast<Handle::Raw>(m_data)), m_size) :
+                    m_size;
+    }
+
+    /// Changes size of the memory block.
+    /// Growing reallocates geometrically, in place where possible;
+    /// the newly available bytes are zeroed. Shrinking keeps the allocation.
+    /// Only empty memory or handle owned by this object may be resized,
+    /// and it must not be locked.
+    /// \throw std::bad_alloc
+    void resize(UInt32 size){
+        assert(m_flags == 0 || (m_flags & Detail::Flags::thisOwns && m_flags & Detail::Flags::Handle));
+
+        auto h = Handle(static_cast<Handle::Raw>(m_data));
+        auto cap = capacity();
+        if (!h || size > cap){
+            auto newCap = h ? Detail::growCapacity(cap, size) : size;
+            m_data = Detail::realloc(h, m_size, newCap).raw();
+            m_flags = Detail::Flags::thisOwns | Detail::Flags::Handle;
+        } else if (size > m_size){
+            // previously shrunk bytes may contain old data
+            auto ptr = static_cast<char*>(Detail::lock(h));
+            std::memset(ptr + m_size, 0, size - m_size);
+            Detail::unlock(h);
+        }
+
+        m_size = size;
+    }
+
+    /// Makes sure the memory block can hold at least `capacity` bytes.
+    /// Size stays the same. Same restrictions as `resize` apply.
+    /// \throw std::bad_alloc
+    void reserve(UInt32 capacity){
+        assert(m_flags == 0 || (m_flags & Detail::Flags::thisOwns && m_flags & Detail::Flags::Handle));
+
+        auto h = Handle(static_cast<Handle::Raw>(m_data));
+        if (!h || capacity > this->capacity()){
+            m_data = Detail::realloc(h, m_size, capacity).raw();
+            m_flags = Detail::Flags::thisOwns | Detail::Flags::Handle;
+        }
+    }
+
     /// In case of handle, frees memory regardless its owner; does nothing otherwise (pointer).
     /// Potentially unsafe operation.
     void free(){
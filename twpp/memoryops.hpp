@@ -63,6 +63,18 @@ struct GlobalMemFuncs {
     static void TWPP_DETAIL_CALLSTYLE defUnlock(Handle::Raw handle){
         ::GlobalUnlock(handle);
     }
+
+    static Handle::Raw defRealloc(Handle::Raw handle, UInt32 oldSize, UInt32 newSize){
+        auto ret = ::GlobalReAlloc(handle, newSize, GMEM_MOVEABLE | GMEM_ZEROINIT);
+        if (ret && newSize > oldSize){
+            // the block may have been larger than oldSize
+            auto ptr = static_cast<char*>(::GlobalLock(ret));
+            std::memset(ptr + oldSize, 0, newSize - oldSize);
+            ::GlobalUnlock(ret);
+        }
+
+        return ret;
+    }
 #elif defined(TWPP_DETAIL_OS_MAC)
     static Handle::Raw TWPP_DETAIL_CALLSTYLE defAlloc(UInt32 size){
         return ::NewHandle(size);
@@ -79,14 +91,249 @@ struct GlobalMemFuncs {
     static void TWPP_DETAIL_CALLSTYLE defUnlock(Handle::Raw){
         // noop
     }
-#elif !defined(TWPP_DETAIL_OS_LINUX) // Linux doesnt need default functions
+
+    static Handle::Raw defRealloc(Handle::Raw handle, UInt32 oldSize, UInt32 newSize){
+        ::SetHandleSize(handle, newSize);
+        if (::MemError() != noErr){
+            return nullptr;
+        }
+
+        if (newSize > oldSize){
+            std::memset(*handle + oldSize, 0, newSize - oldSize);
+        }
+
+        return handle;
+    }
+#elif defined(TWPP_DETAIL_OS_LINUX)
+    // handles are plain pointers, same as with the DSM
+    // blocks of at least `mmapThreshold` bytes are mapped directly
+    static Handle::Raw TWPP_DETAIL_CALLSTYLE defAlloc(UInt32 size){
+        if (size < mmapThreshold.load(std::memory_order_relaxed)){
+            return std::calloc(size, 1);
+        }
+
+        std::size_t length = size;
+        void* ptr = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+        static const std::size_t hugePageSize = 2 * 1024 * 1024;
+        if (hugePages.load(std::memory_order_relaxed)){
+            auto hugeLength = (length + hugePageSize - 1) & ~(hugePageSize - 1);
+            ptr = ::mmap(nullptr, hugeLength, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED){
+                length = hugeLength;
+            }
+        }
+#endif
+
+        if (ptr == MAP_FAILED){
+            ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED){
+                return nullptr;
+            }
+
+#if defined(MADV_HUGEPAGE)
+            if (hugePages.load(std::memory_order_relaxed)){
+                ::madvise(ptr, length, MADV_HUGEPAGE);
+            }
+#endif
+        }
+
+        try {
+            std::lock_guard<std::mutex> lock(mappedMutex);
+            mapped[ptr] = length;
+            mappedCount.fetch_add(1, std::memory_order_release);
+        } catch (...){
+            ::munmap(ptr, length);
+            return nullptr;
+        }
+
+        return ptr;
+    }
+
+    static void TWPP_DETAIL_CALLSTYLE defFree(Handle::Raw handle){
+        if (handle && mappedCount.load(std::memory_order_acquire) != 0){
+            std::unique_lock<std::mutex> lock(mappedMutex);
+            auto it = mapped.find(handle);
+            if (it != mapped.end()){
+                auto length = it->second;
+                mapped.erase(it);
+                mappedCount.fetch_sub(1, std::memory_order_release);
+                lock.unlock();
+
+                ::munmap(handle, length);
+                return;
+            }
+        }
+
+        std::free(handle);
+    }
+
+    static void* TWPP_DETAIL_CALLSTYLE defLock(Handle::Raw handle){
+        return handle;
+    }
+
+    static void TWPP_DETAIL_CALLSTYLE defUnlock(Handle::Raw){
+        // noop
+    }
+
+    static Handle::Raw defRealloc(Handle::Raw handle, UInt32 oldSize, UInt32 newSize){
+        if (mappedCount.load(std::memory_order_acquire) != 0){
+            std::lock_guard<std::mutex> lock(mappedMutex);
+            auto it = mapped.find(handle);
+            if (it != mapped.end()){
+                auto oldLength = it->second;
+                if (newSize > oldLength){
+#if defined(MREMAP_FIXED)
+                    // pages past the old mapping are zeroed by the kernel
+                    auto ptr = ::mremap(handle, oldLength, newSize, 0);
+                    if (ptr != MAP_FAILED){
+                        it->second = newSize;
+                    } else {
+                        // the old mapping is gone once moved, so the new one is reserved
+                        // and recorded first, the way back is still open if that fails
+                        ptr = ::mmap(nullptr, newSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                        if (ptr == MAP_FAILED){
+                            return nullptr;
+                        }
+
+                        try {
+                            mapped[ptr] = newSize;
+                        } catch (...){
+                            ::munmap(ptr, newSize);
+                            return nullptr;
+                        }
+
+                        if (::mremap(handle, oldLength, newSize, MREMAP_MAYMOVE | MREMAP_FIXED, ptr) == MAP_FAILED){
+                            mapped.erase(ptr);
+                            ::munmap(ptr, newSize);
+                            return nullptr;
+                        }
+
+                        // `it` might have been invalidated by the insertion
+                        mapped.erase(handle);
+                    }
+
+                    if (oldLength > oldSize){
+                        std::memset(static_cast<char*>(ptr) + oldSize, 0, oldLength - oldSize);
+                    }
+
+                    return ptr;
+#else
+                    return nullptr;
+#endif
+                }
+
+                // shrinking and growing within the mapping keep it as is
+                if (newSize > oldSize){
+                    std::memset(static_cast<char*>(handle) + oldSize, 0, newSize - oldSize);
+                }
+
+                return handle;
+            }
+        }
+
+        auto ptr = std::realloc(handle, newSize != 0 ? newSize : 1);
+        if (ptr && newSize > oldSize){
+            std::memset(static_cast<char*>(ptr) + oldSize, 0, newSize - oldSize);
+        }
+
+        return ptr;
+    }
+
+    /// Whether the block was mapped by `defAlloc`.
+    static bool isMapped(Handle::Raw handle) noexcept{
+        if (mappedCount.load(std::memory_order_acquire) == 0){
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mappedMutex);
+        return mapped.find(handle) != mapped.end();
+    }
+
+    static std::atomic<UInt32> mmapThreshold;
+    static std::atomic<bool> hugePages;
+    static std::atomic<UInt32> mappedCount;
+    static std::mutex mappedMutex;
+    static std::unordered_map<Handle::Raw, std::size_t> mapped;
+#else
 #   error "default memory functions for your platform here"
 #endif
 
-    static MemAlloc alloc;
-    static MemFree free;
-    static MemLock lock;
-    static MemUnlock unlock;
+    /// Set of memory functions, always published as a whole.
+    struct Table {
+        MemAlloc m_alloc;
+        MemFree m_free;
+        MemLock m_lock;
+        MemUnlock m_unlock;
+    };
+
+    static Handle::Raw alloc(UInt32 size){
+        return table.load(std::memory_order_acquire)->m_alloc(size);
+    }
+
+    static void free(Handle::Raw handle){
+        auto t = table.load(std::memory_order_acquire);
+#if defined(TWPP_DETAIL_OS_LINUX)
+        // blocks mapped before DSM provided its functions must never reach its free()
+        if (t != &defTable && isMapped(handle)){
+            defFree(handle);
+            return;
+        }
+#endif
+
+        t->m_free(handle);
+    }
+
+    static void* lock(Handle::Raw handle){
+        return table.load(std::memory_order_acquire)->m_lock(handle);
+    }
+
+    static void unlock(Handle::Raw handle){
+        table.load(std::memory_order_acquire)->m_unlock(handle);
+    }
+
+    /// Whether the default functions of this platform are in use.
+    static bool isDefault() noexcept{
+        return table.load(std::memory_order_acquire) == &defTable;
+    }
+
+    /// Atomically replaces all memory functions.
+    /// \throw std::bad_alloc
+    static void publish(MemAlloc alloc, MemFree free, MemLock lock, MemUnlock unlock){
+        std::lock_guard<std::mutex> guard(publishMutex);
+
+        const Table* next = &defTable;
+        if (alloc != defTable.m_alloc || free != defTable.m_free ||
+                lock != defTable.m_lock || unlock != defTable.m_unlock){
+
+            // other threads may still be using old tables, never free them
+            // DSMs always provide the same functions, the list stays short
+            next = nullptr;
+            for (const auto& t : tables){
+                if (t.m_alloc == alloc && t.m_free == free && t.m_lock == lock && t.m_unlock == unlock){
+                    next = &t;
+                    break;
+                }
+            }
+
+            if (!next){
+                Table t = {alloc, free, lock, unlock};
+                tables.push_back(t);
+                next = &tables.back();
+            }
+        }
+
+        table.store(next, std::memory_order_release);
+        generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    static const Table defTable;
+    static std::atomic<const Table*> table;
+    static std::atomic<UInt64> generation;
+    static std::mutex publishMutex;
+    static std::list<Table> tables;
 
 #if defined(TWPP_IS_DS)
     static Handle doNotFreeHandle;
@@ -94,32 +341,41 @@ struct GlobalMemFuncs {
 
 };
 
-#if defined(TWPP_DETAIL_OS_WIN) || defined(TWPP_DETAIL_OS_MAC)
 template<typename Dummy>
-MemAlloc GlobalMemFuncs<Dummy>::alloc = GlobalMemFuncs<Dummy>::defAlloc;
+const typename GlobalMemFuncs<Dummy>::Table GlobalMemFuncs<Dummy>::defTable = {
+    GlobalMemFuncs<Dummy>::defAlloc,
+    GlobalMemFuncs<Dummy>::defFree,
+    GlobalMemFuncs<Dummy>::defLock,
+    GlobalMemFuncs<Dummy>::defUnlock
+};
+
+template<typename Dummy>
+std::atomic<const typename GlobalMemFuncs<Dummy>::Table*> GlobalMemFuncs<Dummy>::table(&GlobalMemFuncs<Dummy>::defTable);
 
 template<typename Dummy>
-MemFree GlobalMemFuncs<Dummy>::free = GlobalMemFuncs<Dummy>::defFree;
+std::atomic<UInt64> GlobalMemFuncs<Dummy>::generation(0);
 
 template<typename Dummy>
-MemLock GlobalMemFuncs<Dummy>::lock = GlobalMemFuncs<Dummy>::defLock;
+std::mutex GlobalMemFuncs<Dummy>::publishMutex;
 
 template<typename Dummy>
-MemUnlock GlobalMemFuncs<Dummy>::unlock = GlobalMemFuncs<Dummy>::defUnlock;
-#elif defined(TWPP_DETAIL_OS_LINUX)
+std::list<typename GlobalMemFuncs<Dummy>::Table> GlobalMemFuncs<Dummy>::tables;
+
+#if defined(TWPP_DETAIL_OS_LINUX)
 template<typename Dummy>
-MemAlloc GlobalMemFuncs<Dummy>::alloc = nullptr;
+std::atomic<UInt32> GlobalMemFuncs<Dummy>::mmapThreshold(std::numeric_limits<UInt32>::max());
 
 template<typename Dummy>
-MemFree GlobalMemFuncs<Dummy>::free = nullptr;
+std::atomic<bool> GlobalMemFuncs<Dummy>::hugePages(false);
 
 template<typename Dummy>
-MemLock GlobalMemFuncs<Dummy>::lock = nullptr;
+std::atomic<UInt32> GlobalMemFuncs<Dummy>::mappedCount(0);
 
 template<typename Dummy>
-MemUnlock GlobalMemFuncs<Dummy>::unlock = nullptr;
-#else
-#   error "default memory functions setup for your platform here"
+std::mutex GlobalMemFuncs<Dummy>::mappedMutex;
+
+template<typename Dummy>
+std::unordered_map<Handle::Raw, std::size_t> GlobalMemFuncs<Dummy>::mapped;
 #endif
 
 #if defined(TWPP_IS_DS)
@@ -127,48 +383,728 @@ MemUnlock GlobalMemFuncs<Dummy>::unlock = nullptr;
     Handle GlobalMemFuncs<Dummy>::doNotFreeHandle;
 #endif
 
-inline static void setMemFuncs(MemAlloc alloc, MemFree free, MemLock lock, MemUnlock unlock) noexcept{
-    GlobalMemFuncs<void>::alloc = alloc;
-    GlobalMemFuncs<void>::free = free;
-    GlobalMemFuncs<void>::lock = lock;
-    GlobalMemFuncs<void>::unlock = unlock;
+/// Lock for short critical sections of noexcept functions.
+/// Unlike std::mutex, locking never throws.
+class SpinLock {
+
+public:
+    void lock() noexcept{
+        while (m_flag.test_and_set(std::memory_order_acquire)){
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() noexcept{
+        m_flag.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+
+};
+
+/// Size-class pool of handles layered over GlobalMemFuncs.
+/// Disabled by default, see Twpp::HandlePool.
+template<typename Dummy>
+struct HandlePoolData {
+
+    /// Smallest size class, in bytes.
+    static constexpr UInt32 minClassSize = 64;
+
+    static constexpr UInt32 floorLog2(UInt32 value) noexcept{
+        return value > 1 ? 1 + floorLog2(value >> 1) : 0;
+    }
+
+    /// Maps requested size to size class.
+    /// There are four classes per power of two above `minClassSize`.
+    static constexpr UInt32 classIndex(UInt32 size) noexcept{
+        return size <= minClassSize ? 0 :
+               1 + (floorLog2(size - 1) - 6) * 4 +
+               ((size - 1) / (1u << (floorLog2(size - 1) - 2))) - 4;
+    }
+
+    static constexpr UInt32 classSize(UInt32 index) noexcept{
+        return index == 0 ? minClassSize :
+               (5 + (index - 1) % 4) << (6 + (index - 1) / 4 - 2);
+    }
+
+    /// Size classes of pooled handles, indexed by handle.
+    /// Only the miss path of `alloc` inserts, all other operations are noexcept.
+    typedef SessionTable<UInt32, Handle::Raw, 64> Owned;
+
+    /// Number of handles reserved on each free list when its class is first used.
+    static constexpr UInt32 reservedPerClass = 32;
+
+    /// Number of counters of `hints`.
+    static constexpr UInt32 hintCount = 1024;
+
+    static std::atomic<bool> enabled;
+    static SpinLock mutex;
+
+    /// Smaller allocations never reach the pool, checked without locking.
+    static std::atomic<UInt32> minBlockSize;
+
+    /// Number of pooled handles per hash of their address.
+    /// Zero means the handle is surely not pooled, `free`, `capacity` and `forget`
+    /// of unpooled handles then skip the lock and the index lookup.
+    static std::atomic<UInt32> hints[hintCount];
+
+    static UInt32 maxBlockSize;
+    static UInt32 maxPerClass;
+    static UInt64 maxCachedBytes;
+
+    static std::vector<std::vector<Handle::Raw> > freeLists;
+    static Owned owned;
+
+    static UInt64 hits;
+    static UInt64 misses;
+    static UInt64 bypassed;
+    static UInt64 recycled;
+    static UInt64 released;
+    static UInt64 cachedBytes;
+    static UInt64 cachedHandles;
+
+    /// Tries to serve the allocation from the pool.
+    /// \param size Requested size.
+    /// \param out Allocated handle, set on success.
+    /// \return Whether the pool handled the request.
+    /// \throw std::bad_alloc
+    static bool alloc(UInt32 size, Handle::Raw& out){
+        if (!enabled.load(std::memory_order_relaxed) || size < minBlockSize.load(std::memory_order_relaxed)){
+            return false;
+        }
+
+        std::unique_lock<SpinLock> lock(mutex);
+        if (!enabled.load(std::memory_order_relaxed) || size > maxBlockSize){
+            bypassed++;
+            return false;
+        }
+
+        auto index = classIndex(size);
+        if (index < freeLists.size() && !freeLists[index].empty()){
+            out = freeLists[index].back();
+            freeLists[index].pop_back();
+            cachedBytes -= classSize(index);
+            cachedHandles--;
+            hits++;
+            lock.unlock();
+
+            // keep zero-initialized semantics of the default functions
+            auto ptr = GlobalMemFuncs<Dummy>::lock(out);
+            std::memset(ptr, 0, size);
+            GlobalMemFuncs<Dummy>::unlock(out);
+            return true;
+        }
+
+        misses++;
+        lock.unlock();
+
+        out = GlobalMemFuncs<Dummy>::alloc(classSize(index));
+        if (out){
+            try {
+                lock.lock();
+                track(out, index);
+            } catch (...){
+                lock.unlock();
+                GlobalMemFuncs<Dummy>::free(out);
+                throw;
+            }
+        }
+
+        return true;
+    }
+
+    /// Starts tracking a newly allocated handle.
+    /// Also reserves its free list, so that `free` does not have to allocate.
+    /// \throw std::bad_alloc
+    static void track(Handle::Raw handle, UInt32 index){
+        if (freeLists.size() <= index){
+            freeLists.resize(index + 1);
+        }
+
+        freeLists[index].reserve(std::min(maxPerClass, reservedPerClass));
+
+        // the address may still be tracked if it was passed over without being forgotten
+        untrack(handle);
+
+        auto slot = owned.emplace();
+        owned.at(slot) = index;
+        owned.bind(slot, handle);
+        hint(handle).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void untrack(Handle::Raw handle) noexcept{
+        auto slot = owned.find(handle);
+        if (slot != Owned::npos){
+            untrack(handle, slot);
+        }
+    }
+
+    static void untrack(Handle::Raw handle, UInt32 slot) noexcept{
+        owned.erase(slot);
+        hint(handle).fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static void untrackAll() noexcept{
+        owned.clear();
+        for (auto& h : hints){
+            h.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static std::atomic<UInt32>& hint(Handle::Raw handle) noexcept{
+        auto h = static_cast<UInt64>(std::hash<Handle::Raw>()(handle));
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        return hints[h % hintCount];
+    }
+
+    /// Whether the handle may be pooled, false positives are possible.
+    static bool mayOwn(Handle::Raw handle) noexcept{
+        return enabled.load(std::memory_order_relaxed) && hint(handle).load(std::memory_order_relaxed) != 0;
+    }
+
+    /// Tries to return the handle to the pool.
+    /// \return Whether the pool took care of the handle.
+    static bool free(Handle::Raw handle) noexcept{
+        if (!mayOwn(handle)){
+            return false;
+        }
+
+        std::unique_lock<SpinLock> lock(mutex);
+        auto slot = owned.find(handle);
+        if (slot == Owned::npos){
+            return false;
+        }
+
+        auto index = owned.at(slot);
+        auto size = classSize(index);
+        try {
+            // reserved by `track`, only grows past `reservedPerClass` handles
+            auto& list = freeLists[index];
+            if (list.size() < maxPerClass && cachedBytes + size <= maxCachedBytes){
+                list.push_back(handle);
+                cachedBytes += size;
+                cachedHandles++;
+                recycled++;
+                return true;
+            }
+        } catch (const std::bad_alloc&){
+            // fall through, free the handle instead
+        }
+
+        untrack(handle, slot);
+        released++;
+        lock.unlock();
+
+        GlobalMemFuncs<Dummy>::free(handle);
+        return true;
+    }
+
+    /// Capacity of a pooled handle.
+    /// \return Whether the handle is owned by the pool.
+    static bool capacity(Handle::Raw handle, UInt32& out) noexcept{
+        if (!mayOwn(handle)){
+            return false;
+        }
+
+        std::lock_guard<SpinLock> lock(mutex);
+        auto slot = owned.find(handle);
+        if (slot == Owned::npos){
+            return false;
+        }
+
+        out = classSize(owned.at(slot));
+        return true;
+    }
+
+    /// Stops tracking the handle, it will not be recycled.
+    static void forget(Handle::Raw handle) noexcept{
+        if (!mayOwn(handle)){
+            return;
+        }
+
+        std::lock_guard<SpinLock> lock(mutex);
+        untrack(handle);
+    }
+
+    /// Frees cached handles until at most `keepBytes` remain cached.
+    /// Largest classes are freed first.
+    static void trim(UInt64 keepBytes) noexcept{
+        std::lock_guard<SpinLock> lock(mutex);
+        trimLocked(keepBytes);
+    }
+
+    static void trimLocked(UInt64 keepBytes) noexcept{
+        for (auto i = freeLists.size(); i > 0 && cachedBytes > keepBytes; i--){
+            auto& list = freeLists[i - 1];
+            auto size = classSize(static_cast<UInt32>(i - 1));
+            while (!list.empty() && cachedBytes > keepBytes){
+                auto handle = list.back();
+                list.pop_back();
+                untrack(handle);
+                cachedBytes -= size;
+                cachedHandles--;
+                GlobalMemFuncs<Dummy>::free(handle);
+            }
+        }
+    }
+
+    /// Frees all cached handles and stops tracking the live ones.
+    /// Must be called before the memory functions are replaced.
+    static void reset() noexcept{
+        std::lock_guard<SpinLock> lock(mutex);
+        trimLocked(0);
+        untrackAll();
+    }
+
+};
+
+template<typename Dummy>
+std::atomic<bool> HandlePoolData<Dummy>::enabled(false);
+
+template<typename Dummy>
+SpinLock HandlePoolData<Dummy>::mutex;
+
+template<typename Dummy>
+constexpr UInt32 HandlePoolData<Dummy>::reservedPerClass;
+
+template<typename Dummy>
+constexpr UInt32 HandlePoolData<Dummy>::hintCount;
+
+template<typename Dummy>
+std::atomic<UInt32> HandlePoolData<Dummy>::minBlockSize(0);
+
+template<typename Dummy>
+std::atomic<UInt32> HandlePoolData<Dummy>::hints[HandlePoolData<Dummy>::hintCount];
+
+template<typename Dummy>
+UInt32 HandlePoolData<Dummy>::maxBlockSize = 0;
+
+template<typename Dummy>
+UInt32 HandlePoolData<Dummy>::maxPerClass = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::maxCachedBytes = 0;
+
+template<typename Dummy>
+std::vector<std::vector<Handle::Raw> > HandlePoolData<Dummy>::freeLists;
+
+template<typename Dummy>
+typename HandlePoolData<Dummy>::Owned HandlePoolData<Dummy>::owned;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::hits = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::misses = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::bypassed = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::recycled = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::released = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::cachedBytes = 0;
+
+template<typename Dummy>
+UInt64 HandlePoolData<Dummy>::cachedHandles = 0;
+
+/// Counters of memory operations.
+/// Disabled by default, see Twpp::MemoryTelemetry.
+/// Counters are relaxed atomics, only per-handle tracking takes the mutex.
+template<typename Dummy>
+struct MemTelemetryData {
+
+    struct HandleInfo {
+        UInt32 m_size;
+        UInt32 m_lockDepth;
+    };
+
+    static std::atomic<bool> enabled;
+    static std::atomic<bool> tracking;
+    static std::mutex mutex;
+    static std::unordered_map<Handle::Raw, HandleInfo> handles;
+
+    static std::atomic<UInt64> allocs;
+    static std::atomic<UInt64> frees;
+    static std::atomic<UInt64> allocBytes;
+    static std::atomic<UInt64> liveBytes;
+    static std::atomic<UInt64> peakBytes;
+    static std::atomic<UInt64> locks;
+    static std::atomic<UInt64> unlocks;
+    static UInt32 maxLockDepth;
+
+    static bool isEnabled() noexcept{
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    static bool isTracking() noexcept{
+        return tracking.load(std::memory_order_relaxed);
+    }
+
+    static void allocated(Handle::Raw handle, UInt32 size) noexcept{
+        allocs.fetch_add(1, std::memory_order_relaxed);
+        allocBytes.fetch_add(size, std::memory_order_relaxed);
+        if (!isTracking()){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!isTracking()){
+            return; // disabled meanwhile
+        }
+
+        try {
+            HandleInfo info = {size, 0};
+            handles[handle] = info;
+        } catch (const std::bad_alloc&){
+            // handle is not tracked, still counted as allocated
+            return;
+        }
+
+        // updated under mutex, no need for CAS loop
+        auto live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+        if (live > peakBytes.load(std::memory_order_relaxed)){
+            peakBytes.store(live, std::memory_order_relaxed);
+        }
+    }
+
+    static void freed(Handle::Raw handle) noexcept{
+        frees.fetch_add(1, std::memory_order_relaxed);
+        if (!isTracking()){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = handles.find(handle);
+        if (it != handles.end()){
+            liveBytes.fetch_sub(it->second.m_size, std::memory_order_relaxed);
+            handles.erase(it);
+        }
+    }
+
+    static void resized(Handle::Raw oldHandle, Handle::Raw newHandle, UInt32 newSize) noexcept{
+        if (!isTracking()){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = handles.find(oldHandle);
+        if (it == handles.end()){
+            return;
+        }
+
+        auto info = it->second;
+        liveBytes.fetch_sub(info.m_size, std::memory_order_relaxed);
+        handles.erase(it);
+
+        info.m_size = newSize;
+        try {
+            handles[newHandle] = info;
+        } catch (const std::bad_alloc&){
+            return;
+        }
+
+        auto live = liveBytes.fetch_add(newSize, std::memory_order_relaxed) + newSize;
+        if (live > peakBytes.load(std::memory_order_relaxed)){
+            peakBytes.store(live, std::memory_order_relaxed);
+        }
+    }
+
+    static void locked(Handle::Raw handle) noexcept{
+        locks.fetch_add(1, std::memory_order_relaxed);
+        if (!isTracking()){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = handles.find(handle);
+        if (it != handles.end()){
+            auto depth = ++it->second.m_lockDepth;
+            maxLockDepth = std::max(maxLockDepth, depth);
+        }
+    }
+
+    static void unlocked(Handle::Raw handle) noexcept{
+        unlocks.fetch_add(1, std::memory_order_relaxed);
+        if (!isTracking()){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = handles.find(handle);
+        if (it != handles.end() && it->second.m_lockDepth != 0){
+            it->second.m_lockDepth--;
+        }
+    }
+
+};
+
+template<typename Dummy>
+std::atomic<bool> MemTelemetryData<Dummy>::enabled(false);
+
+template<typename Dummy>
+std::atomic<bool> MemTelemetryData<Dummy>::tracking(false);
+
+template<typename Dummy>
+std::mutex MemTelemetryData<Dummy>::mutex;
+
+template<typename Dummy>
+std::unordered_map<Handle::Raw, typename MemTelemetryData<Dummy>::HandleInfo> MemTelemetryData<Dummy>::handles;
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::allocs(0);
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::frees(0);
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::allocBytes(0);
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::liveBytes(0);
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::peakBytes(0);
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::locks(0);
+
+template<typename Dummy>
+std::atomic<UInt64> MemTelemetryData<Dummy>::unlocks(0);
+
+template<typename Dummy>
+UInt32 MemTelemetryData<Dummy>::maxLockDepth = 0;
+
+/// Capacities of handles grown by `Detail::realloc`.
+template<typename Dummy>
+struct HandleCapacities {
+
+    static std::atomic<UInt32> count;
+    static std::mutex mutex;
+    static std::unordered_map<Handle::Raw, UInt32> capacities;
+
+    static bool find(Handle::Raw handle, UInt32& out) noexcept{
+        if (count.load(std::memory_order_acquire) == 0){
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = capacities.find(handle);
+        if (it == capacities.end()){
+            return false;
+        }
+
+        out = it->second;
+        return true;
+    }
+
+    static void set(Handle::Raw handle, UInt32 capacity) noexcept{
+        std::lock_guard<std::mutex> lock(mutex);
+        try {
+            auto res = capacities.insert(std::make_pair(handle, capacity));
+            if (res.second){
+                count.fetch_add(1, std::memory_order_release);
+            } else {
+                res.first->second = capacity;
+            }
+        } catch (const std::bad_alloc&){
+            // capacity is not known, next growth reallocates
+        }
+    }
+
+    static void erase(Handle::Raw handle) noexcept{
+        if (count.load(std::memory_order_acquire) == 0){
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (capacities.erase(handle) != 0){
+            count.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+};
+
+template<typename Dummy>
+std::atomic<UInt32> HandleCapacities<Dummy>::count(0);
+
+template<typename Dummy>
+std::mutex HandleCapacities<Dummy>::mutex;
+
+template<typename Dummy>
+std::unordered_map<Handle::Raw, UInt32> HandleCapacities<Dummy>::capacities;
+
+/// Replaces memory functions, safe to call while other threads use them.
+/// \throw std::bad_alloc
+inline static void setMemFuncs(MemAlloc alloc, MemFree free, MemLock lock, MemUnlock unlock){
+    HandlePoolData<void>::reset();
+    GlobalMemFuncs<void>::publish(alloc, free, lock, unlock);
 }
 
+/// Restores default memory functions, safe to call while other threads use them.
 inline static void resetMemFuncs() noexcept{
-#if defined(TWPP_DETAIL_OS_WIN) || defined(TWPP_DETAIL_OS_MAC)
-    GlobalMemFuncs<void>::alloc = GlobalMemFuncs<void>::defAlloc;
-    GlobalMemFuncs<void>::free = GlobalMemFuncs<void>::defFree;
-    GlobalMemFuncs<void>::lock = GlobalMemFuncs<void>::defLock;
-    GlobalMemFuncs<void>::unlock = GlobalMemFuncs<void>::defUnlock;
-#elif defined(TWPP_DETAIL_OS_LINUX)
-    GlobalMemFuncs<void>::alloc = nullptr;
-    GlobalMemFuncs<void>::free = nullptr;
-    GlobalMemFuncs<void>::lock = nullptr;
-    GlobalMemFuncs<void>::unlock = nullptr;
-#else
-#   error "resetMemFuncs for your platform here"
-#endif
+    HandlePoolData<void>::reset();
+
+    std::lock_guard<std::mutex> guard(GlobalMemFuncs<void>::publishMutex);
+    GlobalMemFuncs<void>::table.store(&GlobalMemFuncs<void>::defTable, std::memory_order_release);
+    GlobalMemFuncs<void>::generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+/// Number of times memory functions have been replaced.
+/// Handles allocated in different generations may not be compatible.
+inline static UInt64 memFuncsGeneration() noexcept{
+    return GlobalMemFuncs<void>::generation.load(std::memory_order_acquire);
 }
 
 inline static Handle alloc(UInt32 size){
-    auto h = GlobalMemFuncs<void>::alloc(size);
+    Handle::Raw h;
+    if (!HandlePoolData<void>::alloc(size, h)){
+        h = GlobalMemFuncs<void>::alloc(size);
+
+        // the address might have belonged to a pooled handle passed over to the other side
+        HandlePoolData<void>::forget(h);
+    }
+
     if (!h){
         throw std::bad_alloc();
     }
 
+    // same for a grown handle, its capacity must not be inherited
+    HandleCapacities<void>::erase(h);
+
+    if (MemTelemetryData<void>::isEnabled()){
+        MemTelemetryData<void>::allocated(h, size);
+    }
+
     return Handle(h);
 }
 
 inline static void* lock(Handle handle) noexcept{
+    if (MemTelemetryData<void>::isEnabled()){
+        MemTelemetryData<void>::locked(handle.raw());
+    }
+
     return GlobalMemFuncs<void>::lock(handle.raw());
 }
 
 inline static void unlock(Handle handle) noexcept{
+    if (MemTelemetryData<void>::isEnabled()){
+        MemTelemetryData<void>::unlocked(handle.raw());
+    }
+
     GlobalMemFuncs<void>::unlock(handle.raw());
 }
 
 inline static void free(Handle handle) noexcept{
-    GlobalMemFuncs<void>::free(handle.raw());
+    if (MemTelemetryData<void>::isEnabled()){
+        MemTelemetryData<void>::freed(handle.raw());
+    }
+
+    HandleCapacities<void>::erase(handle.raw());
+
+    if (!HandlePoolData<void>::free(handle.raw())){
+        GlobalMemFuncs<void>::free(handle.raw());
+    }
+}
+
+/// Whether the pool or the capacity table keeps track of any handle, see `disown`.
+inline static bool tracksHandles() noexcept{
+    return HandlePoolData<void>::enabled.load(std::memory_order_relaxed) ||
+           HandleCapacities<void>::count.load(std::memory_order_acquire) != 0;
+}
+
+/// Drops all bookkeeping of a handle passed over to the other side.
+/// The other side frees the handle on its own, its address may then be reused by an unrelated allocation.
+inline static void disown(Handle handle) noexcept{
+    HandlePoolData<void>::forget(handle.raw());
+    HandleCapacities<void>::erase(handle.raw());
+}
+
+/// Number of bytes usable in the handle without reallocation.
+/// \param size Size to report for handles of unknown capacity.
+inline static UInt32 capacity(Handle handle, UInt32 size) noexcept{
+    UInt32 ret;
+    if (HandlePoolData<void>::capacity(handle.raw(), ret) ||
+            HandleCapacities<void>::find(handle.raw(), ret)){
+        return std::max(ret, size);
+    }
+
+    return size;
+}
+
+/// Changes size of the handle, possibly moving it.
+/// Contents are preserved up to the smaller of both sizes, rest is zeroed.
+/// The handle must not be locked.
+/// \param handle Handle to resize, empty handle allocates new one.
+/// \param oldSize Number of bytes currently used in the handle.
+/// \param newSize Requested size.
+/// \return Resized handle, the original one must not be used anymore.
+/// \throw std::bad_alloc On failure, the original handle is kept intact.
+inline static Handle realloc(Handle handle, UInt32 oldSize, UInt32 newSize){
+    if (!handle){
+        auto ret = alloc(newSize);
+        HandleCapacities<void>::set(ret.raw(), newSize);
+        return ret;
+    }
+
+    UInt32 poolCapacity;
+    bool pooled = HandlePoolData<void>::capacity(handle.raw(), poolCapacity);
+    if (pooled && newSize <= poolCapacity){
+        if (newSize > oldSize){
+            auto ptr = static_cast<char*>(GlobalMemFuncs<void>::lock(handle.raw()));
+            std::memset(ptr + oldSize, 0, newSize - oldSize);
+            GlobalMemFuncs<void>::unlock(handle.raw());
+        }
+
+        if (MemTelemetryData<void>::isEnabled()){
+            MemTelemetryData<void>::resized(handle.raw(), handle.raw(), newSize);
+        }
+
+        return handle;
+    }
+
+    if (!pooled && GlobalMemFuncs<void>::isDefault()){
+        auto h = GlobalMemFuncs<void>::defRealloc(handle.raw(), oldSize, newSize);
+        if (h){
+            HandlePoolData<void>::forget(h);
+            HandleCapacities<void>::erase(handle.raw());
+            if (MemTelemetryData<void>::isEnabled()){
+                MemTelemetryData<void>::resized(handle.raw(), h, newSize);
+            }
+
+            HandleCapacities<void>::set(h, newSize);
+            return Handle(h);
+        }
+    }
+
+    // memory functions of the DSM, or in-place resize failed
+    auto ret = alloc(newSize);
+    auto from = static_cast<const char*>(lock(handle));
+    auto to = static_cast<char*>(lock(ret));
+    auto copied = std::min(oldSize, newSize);
+    std::copy(from, from + copied, to);
+    std::memset(to + copied, 0, newSize - copied);
+    unlock(ret);
+    unlock(handle);
+    free(handle);
+
+    HandleCapacities<void>::set(ret.raw(), newSize);
+    return ret;
+}
+
+/// Capacity for growing from `capacity` to at least `minSize` bytes.
+/// Grows by half of the current capacity.
+static inline UInt32 growCapacity(UInt32 capacity, UInt32 minSize) noexcept{
+    auto geometric = static_cast<UInt64>(capacity) + capacity / 2;
+    auto max = static_cast<UInt64>(std::numeric_limits<UInt32>::max());
+    return static_cast<UInt32>(std::max<UInt64>(minSize, std::min(geometric, max)));
 }
 
 template<typename T>
@@ -176,34 +1112,97 @@ static inline T* typeLock(Handle handle) noexcept{
     return static_cast<T*>(lock(handle));
 }
 
+/// Reference count shared by copies of a lock.
+/// Copies of a lock share the locked pointer instead of locking the handle again,
+/// the handle is unlocked once the last copy is destroyed.
+/// The count is allocated upon the first copy, a lock that is never copied costs nothing.
+class LockRefs {
+
+public:
+    constexpr LockRefs() noexcept :
+        m_refs(nullptr){}
+
+    LockRefs(const LockRefs&) = delete;
+    LockRefs& operator=(const LockRefs&) = delete;
+
+    /// Makes `other` share the count with this object.
+    /// \return False if the count could not be allocated, `other` must lock on its own.
+    bool shareTo(LockRefs& other) const noexcept{
+        auto refs = m_refs.load(std::memory_order_acquire);
+        if (!refs){
+            auto created = new (std::nothrow) std::atomic<UInt32>(1);
+            if (!created){
+                return false;
+            }
+
+            if (m_refs.compare_exchange_strong(refs, created, std::memory_order_acq_rel)){
+                refs = created;
+            } else {
+                delete created;
+            }
+        }
+
+        refs->fetch_add(1, std::memory_order_relaxed);
+        other.m_refs.store(refs, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Takes over the count of `other`.
+    void moveFrom(LockRefs& other) noexcept{
+        m_refs.store(other.m_refs.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    /// Drops a reference.
+    /// \return Whether this was the last reference and the handle must be unlocked.
+    bool release() noexcept{
+        auto refs = m_refs.exchange(nullptr, std::memory_order_relaxed);
+        if (!refs){
+            return true;
+        }
+
+        if (refs->fetch_sub(1, std::memory_order_acq_rel) == 1){
+            delete refs;
+            return true;
+        }
+
+        return false;
+    }
+
+private:
+    mutable std::atomic<std::atomic<UInt32>*> m_refs;
+
+};
+
 /// A lock that can contain either handle or raw pointer.
 /// Locks and unlocks handle, noop for pointer.
+/// Copies share the lock, see LockRefs.
 template<typename T>
 class MaybeLock {
 
 public:
     constexpr MaybeLock() noexcept :
-        m_handle(), m_pointer(nullptr){}
+        m_handle(), m_pointer(nullptr), m_refs(){}
 
     MaybeLock(Handle h) noexcept :
-        m_handle(h), m_pointer(typeLock<T>(h)){}
+        m_handle(h), m_pointer(typeLock<T>(h)), m_refs(){}
 
     constexpr MaybeLock(T* ptr) noexcept :
-        m_handle(), m_pointer(ptr){}
+        m_handle(), m_pointer(ptr), m_refs(){}
 
     ~MaybeLock(){
         unlock();
     }
 
     MaybeLock(const MaybeLock& o) noexcept :
-        m_handle(o.m_handle), m_pointer(o.m_handle ? typeLock<T>(o.m_handle) : o.m_pointer){}
+        m_handle(), m_pointer(nullptr), m_refs(){
+
+        copyFrom(o);
+    }
 
     MaybeLock& operator=(const MaybeLock& o) noexcept{
         if (&o != this){
             unlock();
-
-            m_handle = o.m_handle;
-            m_pointer = m_handle ? typeLock<T>(m_handle) : o.m_pointer;
+            copyFrom(o);
         }
 
         return *this;
@@ -211,8 +1210,9 @@ public:
 
 
     MaybeLock(MaybeLock&& o) noexcept :
-        m_handle(o.m_handle), m_pointer(o.m_pointer){
+        m_handle(o.m_handle), m_pointer(o.m_pointer), m_refs(){
 
+        m_refs.moveFrom(o.m_refs);
         o.m_handle = Handle();
         o.m_pointer = nullptr;
     }
@@ -223,6 +1223,7 @@ public:
 
             m_handle = o.m_handle;
             m_pointer = o.m_pointer;
+            m_refs.moveFrom(o.m_refs);
 
             o.m_handle = Handle();
             o.m_pointer = nullptr;
@@ -256,28 +1257,39 @@ public:
     }
 
 private:
+    void copyFrom(const MaybeLock& o) noexcept{
+        m_handle = o.m_handle;
+        if (m_handle && !o.m_refs.shareTo(m_refs)){
+            m_pointer = typeLock<T>(m_handle);
+        } else {
+            m_pointer = o.m_pointer;
+        }
+    }
+
     void unlock() noexcept{
-        if (m_handle){
+        if (m_refs.release() && m_handle){
             Detail::unlock(m_handle);
         }
     }
 
     Handle m_handle;
     T* m_pointer;
+    LockRefs m_refs;
 
 };
 
 /// Simple handle lock.
 /// Locks on creation and unlocks on destruction.
+/// Copies share the lock, see LockRefs.
 template<typename T>
 class Lock {
 
 public:
     constexpr Lock() noexcept :
-        m_handle(), m_pointer(nullptr){}
+        m_handle(), m_pointer(nullptr), m_refs(){}
 
     Lock(Handle h) noexcept :
-        m_handle(h), m_pointer(typeLock<T>(h)){}
+        m_handle(h), m_pointer(typeLock<T>(h)), m_refs(){}
 
     ~Lock(){
         unlock();
@@ -285,14 +1297,15 @@ public:
 
 
     Lock(const Lock& o) noexcept :
-        m_handle(o.m_handle), m_pointer(typeLock<T>(o.m_handle)){}
+        m_handle(), m_pointer(nullptr), m_refs(){
+
+        copyFrom(o);
+    }
 
     Lock& operator=(const Lock& o) noexcept{
         if (&o != this){
             unlock();
-
-            m_handle = o.m_handle;
-            m_pointer = typeLock<T>(m_handle);
+            copyFrom(o);
         }
 
         return *this;
@@ -300,8 +1313,9 @@ public:
 
 
     Lock(Lock&& o) noexcept :
-        m_handle(o.m_handle), m_pointer(o.m_pointer){
+        m_handle(o.m_handle), m_pointer(o.m_pointer), m_refs(){
 
+        m_refs.moveFrom(o.m_refs);
         o.m_handle = Handle();
         o.m_pointer = nullptr;
     }
@@ -312,6 +1326,7 @@ public:
 
             m_handle = o.m_handle;
             m_pointer = o.m_pointer;
+            m_refs.moveFrom(o.m_refs);
 
             o.m_handle = Handle();
             o.m_pointer = nullptr;
@@ -346,14 +1361,24 @@ public:
     }
 
 private:
+    void copyFrom(const Lock& o) noexcept{
+        m_handle = o.m_handle;
+        if (m_handle && !o.m_refs.shareTo(m_refs)){
+            m_pointer = typeLock<T>(m_handle);
+        } else {
+            m_pointer = o.m_pointer;
+        }
+    }
+
     void unlock() noexcept{
-        if (m_handle){
+        if (m_refs.release() && m_handle){
             Detail::unlock(m_handle);
         }
     }
 
     Handle m_handle;
     T* m_pointer;
+    LockRefs m_refs;
 
 };
 
@@ -416,6 +1441,25 @@ public:
         return m_handle;
     }
 
+    /// Makes sure the handle can hold at least `minSize` bytes.
+    /// Capacity grows geometrically, the handle may move.
+    /// Contents are preserved up to `usedSize`, rest is zeroed.
+    /// The handle must not be locked.
+    /// \param usedSize Number of bytes currently used in the handle.
+    /// \param minSize Required number of bytes.
+    /// \return New capacity of the handle.
+    /// \throw std::bad_alloc
+    UInt32 grow(UInt32 usedSize, UInt32 minSize){
+        auto cap = capacity(m_handle, usedSize);
+        if (m_handle && minSize <= cap){
+            return cap;
+        }
+
+        cap = m_handle ? growCapacity(cap, minSize) : minSize;
+        m_handle = realloc(m_handle, usedSize, cap);
+        return cap;
+    }
+
 private:
     void free() noexcept{
 #if defined(TWPP_IS_DS)
@@ -433,6 +1477,335 @@ private:
 
 }
 
+/// Optional pool of handles sorted by size classes.
+/// When enabled, handles allocated by TWPP are kept on free lists
+/// upon being freed and reused by later allocations of similar size.
+/// Recycled memory is zeroed up to the requested size.
+/// Handles passed over to the other side (DSM, application or source)
+/// must not be recycled, see `forget`. Capability, native transfer, custom data
+/// and extended image info handles returned by a data source are forgotten automatically.
+/// The pool only pays off for large blocks such as image strips, smaller allocations
+/// bypass it without locking, see `enable`. Disabled by default.
+class HandlePool {
+
+public:
+    /// Pool statistics.
+    class Stats {
+
+    public:
+        constexpr Stats() noexcept :
+            m_hits(0), m_misses(0), m_bypassed(0), m_recycled(0),
+            m_released(0), m_cachedBytes(0), m_cachedHandles(0){}
+
+        constexpr Stats(UInt64 hits, UInt64 misses, UInt64 bypassed, UInt64 recycled,
+                        UInt64 released, UInt64 cachedBytes, UInt64 cachedHandles) noexcept :
+            m_hits(hits), m_misses(misses), m_bypassed(bypassed), m_recycled(recycled),
+            m_released(released), m_cachedBytes(cachedBytes), m_cachedHandles(cachedHandles){}
+
+        /// Number of allocations served from the pool.
+        constexpr UInt64 hits() const noexcept{
+            return m_hits;
+        }
+
+        /// Number of poolable allocations that had to allocate new handle.
+        constexpr UInt64 misses() const noexcept{
+            return m_misses;
+        }
+
+        /// Number of allocations too large for the pool.
+        constexpr UInt64 bypassed() const noexcept{
+            return m_bypassed;
+        }
+
+        /// Number of handles returned to the pool.
+        constexpr UInt64 recycled() const noexcept{
+            return m_recycled;
+        }
+
+        /// Number of pooled handles freed because the pool was full.
+        constexpr UInt64 released() const noexcept{
+            return m_released;
+        }
+
+        /// Total size of cached handles, in bytes.
+        constexpr UInt64 cachedBytes() const noexcept{
+            return m_cachedBytes;
+        }
+
+        /// Number of cached handles.
+        constexpr UInt64 cachedHandles() const noexcept{
+            return m_cachedHandles;
+        }
+
+    private:
+        UInt64 m_hits;
+        UInt64 m_misses;
+        UInt64 m_bypassed;
+        UInt64 m_recycled;
+        UInt64 m_released;
+        UInt64 m_cachedBytes;
+        UInt64 m_cachedHandles;
+
+    };
+
+    /// Enables the pool, or changes its limits when already enabled.
+    /// \param maxBlockSize Largest allocation served by the pool, at most 1 GiB.
+    /// \param maxPerClass Maximal number of cached handles per size class.
+    /// \param maxCachedBytes Maximal total size of cached handles.
+    /// \param minBlockSize Smallest allocation served by the pool.
+    ///        Smaller blocks are as fast or faster without the pool.
+    static void enable(UInt32 maxBlockSize = 16 * 1024 * 1024, UInt32 maxPerClass = 32,
+                       UInt64 maxCachedBytes = 64 * 1024 * 1024, UInt32 minBlockSize = 64 * 1024) noexcept{
+        typedef Detail::HandlePoolData<void> Data;
+
+        std::lock_guard<Detail::SpinLock> lock(Data::mutex);
+        Data::maxBlockSize = std::min<UInt32>(maxBlockSize, 1u << 30);
+        Data::maxPerClass = maxPerClass;
+        Data::maxCachedBytes = maxCachedBytes;
+        Data::minBlockSize.store(minBlockSize, std::memory_order_relaxed);
+        Data::trimLocked(maxCachedBytes);
+        Data::enabled.store(true, std::memory_order_relaxed);
+    }
+
+    /// Disables the pool and frees all cached handles.
+    /// Live pooled handles are freed directly once they are released.
+    static void disable() noexcept{
+        typedef Detail::HandlePoolData<void> Data;
+
+        std::lock_guard<Detail::SpinLock> lock(Data::mutex);
+        Data::enabled.store(false, std::memory_order_relaxed);
+        Data::trimLocked(0);
+        Data::untrackAll();
+    }
+
+    /// Whether the pool is enabled.
+    static bool isEnabled() noexcept{
+        return Detail::HandlePoolData<void>::enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Frees cached handles until at most `keepBytes` remain cached.
+    static void trim(UInt64 keepBytes = 0) noexcept{
+        Detail::HandlePoolData<void>::trim(keepBytes);
+    }
+
+    /// Stops tracking the handle, it is freed directly instead of being recycled.
+    /// Use for handles whose ownership is passed to the other side.
+    static void forget(Handle handle) noexcept{
+        Detail::HandlePoolData<void>::forget(handle.raw());
+    }
+
+    /// Current pool statistics.
+    static Stats stats() noexcept{
+        typedef Detail::HandlePoolData<void> Data;
+
+        std::lock_guard<Detail::SpinLock> lock(Data::mutex);
+        return Stats(Data::hits, Data::misses, Data::bypassed, Data::recycled,
+                     Data::released, Data::cachedBytes, Data::cachedHandles);
+    }
+
+    /// Resets hit, miss, bypass, recycle and release counters.
+    static void resetStats() noexcept{
+        typedef Detail::HandlePoolData<void> Data;
+
+        std::lock_guard<Detail::SpinLock> lock(Data::mutex);
+        Data::hits = 0;
+        Data::misses = 0;
+        Data::bypassed = 0;
+        Data::recycled = 0;
+        Data::released = 0;
+    }
+
+};
+
+/// Optional counters of handle allocations and locks.
+/// Only operations made through TWPP while enabled are counted.
+/// Sizes are the requested ones, regardless of any pooling.
+/// Counting alone costs a few relaxed atomic increments per operation,
+/// live bytes and lock depths require the slower per-handle tracking, see `enable`.
+class MemoryTelemetry {
+
+public:
+    /// Point-in-time copy of the counters.
+    class Snapshot {
+
+    public:
+        constexpr Snapshot() noexcept :
+            m_allocs(0), m_frees(0), m_allocBytes(0), m_liveBytes(0), m_peakBytes(0),
+            m_liveHandles(0), m_locks(0), m_unlocks(0), m_lockedHandles(0), m_maxLockDepth(0){}
+
+        constexpr Snapshot(UInt64 allocs, UInt64 frees, UInt64 allocBytes, UInt64 liveBytes,
+                           UInt64 peakBytes, UInt64 liveHandles, UInt64 locks, UInt64 unlocks,
+                           UInt64 lockedHandles, UInt32 maxLockDepth) noexcept :
+            m_allocs(allocs), m_frees(frees), m_allocBytes(allocBytes), m_liveBytes(liveBytes),
+            m_peakBytes(peakBytes), m_liveHandles(liveHandles), m_locks(locks), m_unlocks(unlocks),
+            m_lockedHandles(lockedHandles), m_maxLockDepth(maxLockDepth){}
+
+        /// Number of allocated handles.
+        constexpr UInt64 allocs() const noexcept{
+            return m_allocs;
+        }
+
+        /// Number of freed handles.
+        constexpr UInt64 frees() const noexcept{
+            return m_frees;
+        }
+
+        /// Total number of allocated bytes.
+        constexpr UInt64 allocBytes() const noexcept{
+            return m_allocBytes;
+        }
+
+        /// Bytes in handles allocated and not yet freed.
+        /// Requires handle tracking, zero otherwise.
+        constexpr UInt64 liveBytes() const noexcept{
+            return m_liveBytes;
+        }
+
+        /// Highest value of `liveBytes` since enabled or reset.
+        /// Requires handle tracking, zero otherwise.
+        constexpr UInt64 peakBytes() const noexcept{
+            return m_peakBytes;
+        }
+
+        /// Number of handles allocated and not yet freed.
+        /// Requires handle tracking, zero otherwise.
+        constexpr UInt64 liveHandles() const noexcept{
+            return m_liveHandles;
+        }
+
+        /// Number of lock calls.
+        constexpr UInt64 locks() const noexcept{
+            return m_locks;
+        }
+
+        /// Number of unlock calls.
+        constexpr UInt64 unlocks() const noexcept{
+            return m_unlocks;
+        }
+
+        /// Number of live handles that are currently locked.
+        /// Requires handle tracking, zero otherwise.
+        constexpr UInt64 lockedHandles() const noexcept{
+            return m_lockedHandles;
+        }
+
+        /// Highest lock depth reached by a single handle.
+        /// Requires handle tracking, zero otherwise.
+        constexpr UInt32 maxLockDepth() const noexcept{
+            return m_maxLockDepth;
+        }
+
+    private:
+        UInt64 m_allocs;
+        UInt64 m_frees;
+        UInt64 m_allocBytes;
+        UInt64 m_liveBytes;
+        UInt64 m_peakBytes;
+        UInt64 m_liveHandles;
+        UInt64 m_locks;
+        UInt64 m_unlocks;
+        UInt64 m_lockedHandles;
+        UInt32 m_maxLockDepth;
+
+    };
+
+    /// Starts counting.
+    /// \param trackHandles Whether to also track size and lock depth of each handle,
+    ///        needed for live bytes and lock depths. Takes a global lock on every operation.
+    static void enable(bool trackHandles = false) noexcept{
+        typedef Detail::MemTelemetryData<void> Data;
+
+        std::lock_guard<std::mutex> lock(Data::mutex);
+        if (!trackHandles){
+            Data::handles.clear();
+            Data::liveBytes.store(0, std::memory_order_relaxed);
+        }
+
+        Data::tracking.store(trackHandles, std::memory_order_relaxed);
+        Data::enabled.store(true, std::memory_order_relaxed);
+    }
+
+    /// Stops counting and forgets tracked handles, counters keep their values.
+    static void disable() noexcept{
+        typedef Detail::MemTelemetryData<void> Data;
+
+        std::lock_guard<std::mutex> lock(Data::mutex);
+        Data::enabled.store(false, std::memory_order_relaxed);
+        Data::tracking.store(false, std::memory_order_relaxed);
+        Data::handles.clear();
+        Data::liveBytes.store(0, std::memory_order_relaxed);
+    }
+
+    /// Whether counting is enabled.
+    static bool isEnabled() noexcept{
+        return Detail::MemTelemetryData<void>::isEnabled();
+    }
+
+    /// Resets cumulative counters, live handles remain tracked.
+    /// Peak is set to the current live bytes.
+    static void reset() noexcept{
+        typedef Detail::MemTelemetryData<void> Data;
+
+        std::lock_guard<std::mutex> lock(Data::mutex);
+        Data::allocs.store(0, std::memory_order_relaxed);
+        Data::frees.store(0, std::memory_order_relaxed);
+        Data::allocBytes.store(0, std::memory_order_relaxed);
+        Data::peakBytes.store(Data::liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        Data::locks.store(0, std::memory_order_relaxed);
+        Data::unlocks.store(0, std::memory_order_relaxed);
+        Data::maxLockDepth = 0;
+    }
+
+    /// Current lock depth of a handle, zero for unknown handles or without handle tracking.
+    static UInt32 lockDepth(Handle handle) noexcept{
+        typedef Detail::MemTelemetryData<void> Data;
+
+        std::lock_guard<std::mutex> lock(Data::mutex);
+        auto it = Data::handles.find(handle.raw());
+        return it != Data::handles.end() ? it->second.m_lockDepth : 0;
+    }
+
+    /// Copy of all counters.
+    static Snapshot snapshot() noexcept{
+        typedef Detail::MemTelemetryData<void> Data;
+
+        std::lock_guard<std::mutex> lock(Data::mutex);
+        UInt64 locked = 0;
+        for (const auto& entry : Data::handles){
+            if (entry.second.m_lockDepth != 0){
+                locked++;
+            }
+        }
+
+        return Snapshot(
+            Data::allocs.load(std::memory_order_relaxed),
+            Data::frees.load(std::memory_order_relaxed),
+            Data::allocBytes.load(std::memory_order_relaxed),
+            Data::liveBytes.load(std::memory_order_relaxed),
+            Data::peakBytes.load(std::memory_order_relaxed),
+            Data::handles.size(),
+            Data::locks.load(std::memory_order_relaxed),
+            Data::unlocks.load(std::memory_order_relaxed),
+            locked,
+            Data::maxLockDepth
+        );
+    }
+
+};
+
+#if defined(TWPP_DETAIL_OS_LINUX)
+/// Configures default memory functions, used until DSM provides its own.
+/// Mapped blocks are always released by the default functions, even after DSM provided its own.
+/// \param mmapThreshold Blocks of at least this size are backed by anonymous mapping
+///        instead of heap. Zero maps all blocks, `UINT32_MAX` (default) disables mapping.
+/// \param hugePages Whether mapped blocks should use huge pages.
+///        Explicit huge pages are tried first, transparent ones are requested otherwise.
+inline static void setDefaultMemOptions(UInt32 mmapThreshold, bool hugePages = false) noexcept{
+    Detail::GlobalMemFuncs<void>::mmapThreshold.store(mmapThreshold, std::memory_order_relaxed);
+    Detail::GlobalMemFuncs<void>::hugePages.store(hugePages, std::memory_order_relaxed);
+}
+#endif
+
 }
 
 #endif // TWPP_DETAIL_FILE_MEMORYOPS_HPP
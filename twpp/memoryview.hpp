@@ -0,0 +1,173 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_MEMORYVIEW_HPP
+#define TWPP_DETAIL_FILE_MEMORYVIEW_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// Non-owning view of a contiguous part of memory block.
+/// Keeps the underlying handle locked as long as the view exists.
+/// The memory block must outlive the view.
+template<typename T>
+class BasicMemoryView {
+
+public:
+    typedef Detail::MaybeLock<T> Data;
+
+    /// Creates an empty view.
+    constexpr BasicMemoryView() noexcept :
+        m_lock(), m_data(nullptr), m_size(0){}
+
+    /// Creates a view of `size` bytes starting at `offset` of locked data.
+    BasicMemoryView(Data lock, UInt32 offset, UInt32 size) noexcept :
+        m_lock(std::move(lock)), m_data(m_lock.data() + offset), m_size(size){}
+
+    /// First byte of the view.
+    T* data() const noexcept{
+        return m_data;
+    }
+
+    /// Number of bytes in the view.
+    UInt32 size() const noexcept{
+        return m_size;
+    }
+
+    bool empty() const noexcept{
+        return m_size == 0;
+    }
+
+    T* begin() const noexcept{
+        return m_data;
+    }
+
+    T* end() const noexcept{
+        return m_data + m_size;
+    }
+
+    T& operator[](UInt32 i) const noexcept{
+        return m_data[i];
+    }
+
+    /// Sub-range of this view, no data are copied.
+    /// \param offset Offset relative to this view.
+    /// \param size Number of bytes, clamped to the end of this view.
+    BasicMemoryView slice(UInt32 offset, UInt32 size) const noexcept{
+        assert(offset <= m_size);
+        return BasicMemoryView(m_lock, static_cast<UInt32>(m_data - m_lock.data()) + offset,
+                               std::min(size, m_size - offset));
+    }
+
+private:
+    Data m_lock;
+    T* m_data;
+    UInt32 m_size;
+
+};
+
+typedef BasicMemoryView<char> MemoryView;
+typedef BasicMemoryView<const char> ConstMemoryView;
+
+
+/// Non-owning strided view of image rows in memory block.
+/// Keeps the underlying handle locked as long as the view exists.
+/// The memory block must outlive the view.
+template<typename T>
+class BasicImageView {
+
+public:
+    typedef Detail::MaybeLock<T> Data;
+
+    /// Creates an empty view.
+    constexpr BasicImageView() noexcept :
+        m_lock(), m_first(nullptr), m_rows(0), m_bytesPerRow(0), m_stride(0){}
+
+    /// Creates a view of image rows in locked data.
+    /// \param lock Locked data.
+    /// \param offset Offset of the first row in memory, not the lowest address in case of bottom-up images.
+    /// \param rows Number of rows.
+    /// \param bytesPerRow Number of bytes in a single row, including padding.
+    /// \param stride Distance between starts of two consecutive rows in bytes,
+    ///        negative for bottom-up images. Its absolute value is at least `bytesPerRow`.
+    BasicImageView(Data lock, UInt32 offset, UInt32 rows, UInt32 bytesPerRow, Int32 stride) noexcept :
+        m_lock(std::move(lock)), m_first(m_lock.data() + offset), m_rows(rows),
+        m_bytesPerRow(bytesPerRow), m_stride(stride){}
+
+    /// Number of rows.
+    UInt32 rows() const noexcept{
+        return m_rows;
+    }
+
+    /// Number of bytes in a single row, including padding.
+    UInt32 bytesPerRow() const noexcept{
+        return m_bytesPerRow;
+    }
+
+    /// Distance between starts of two consecutive rows in bytes.
+    Int32 stride() const noexcept{
+        return m_stride;
+    }
+
+    bool empty() const noexcept{
+        return m_rows == 0;
+    }
+
+    /// Start of row with the supplied index.
+    T* row(UInt32 index) const noexcept{
+        return m_first + static_cast<std::ptrdiff_t>(index) * m_stride;
+    }
+
+    T* operator[](UInt32 index) const noexcept{
+        return row(index);
+    }
+
+    /// Band of consecutive rows, no data are copied.
+    /// \param firstRow Index of the first row in the band.
+    /// \param rows Number of rows, clamped to the end of this view.
+    BasicImageView band(UInt32 firstRow, UInt32 rows) const noexcept{
+        assert(firstRow <= m_rows);
+        return BasicImageView(m_lock, static_cast<UInt32>(row(firstRow) - m_lock.data()),
+                              std::min(rows, m_rows - firstRow), m_bytesPerRow, m_stride);
+    }
+
+private:
+    Data m_lock;
+    T* m_first;
+    UInt32 m_rows;
+    UInt32 m_bytesPerRow;
+    Int32 m_stride;
+
+};
+
+typedef BasicImageView<char> ImageView;
+typedef BasicImageView<const char> ConstImageView;
+
+}
+
+#endif // TWPP_DETAIL_FILE_MEMORYVIEW_HPP
+
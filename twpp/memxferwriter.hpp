@@ -0,0 +1,254 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#ifndef TWPP_DETAIL_FILE_MEMXFERWRITER_HPP
+#define TWPP_DETAIL_FILE_MEMXFERWRITER_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// Writes uncompressed image rows into memory transfers of a data source.
+/// Checks the application buffer, computes rows (or tiles) per buffer,
+/// fills ImageMemXfer fields, tracks offsets and reports XferDone after the last rows.
+///
+/// Rows are read either from memory, `firstRow + y * stride`, or from a function returning row pointers.
+/// Whole strips are copied at once when the source stride matches bytes per row.
+///
+/// Usage in `imageMemXferGet`:
+/// `return m_writer.write(data, setup);`
+class MemXferWriter {
+
+public:
+    /// Returns pointer to the row of the source image.
+    typedef std::function<const char*(UInt32 row)> RowFunc;
+
+    /// Creates writer without any image, every write fails.
+    MemXferWriter() noexcept :
+        m_first(nullptr), m_stride(0), m_bytesPerRow(0), m_columns(0), m_rows(0), m_bitsPerPixel(0),
+        m_tiles(false), m_tileColumns(0), m_tileRows(0), m_x(0), m_y(0){}
+
+    /// Creates writer of an image in memory.
+    /// \param firstRow The top row of the image.
+    /// \param stride Distance between rows in bytes, negative for bottom-up images, e.g. BMP.
+    /// \param bytesPerRow Number of bytes of a single transferred row, including padding.
+    /// \param columns Width of the image in pixels.
+    /// \param rows Height of the image in pixels.
+    /// \param bitsPerPixel Number of bits of a single pixel, needed for tiles.
+    MemXferWriter(const char* firstRow, Int32 stride, UInt32 bytesPerRow, UInt32 columns, UInt32 rows, UInt16 bitsPerPixel) noexcept :
+        m_first(firstRow), m_stride(stride), m_bytesPerRow(bytesPerRow), m_columns(columns), m_rows(rows),
+        m_bitsPerPixel(bitsPerPixel), m_tiles(false), m_tileColumns(0), m_tileRows(0), m_x(0), m_y(0){}
+
+    /// Creates writer of an image read row by row.
+    /// \param rowFunc Returns pointer to the row, called once per row and buffer.
+    /// \param bytesPerRow Number of bytes of a single transferred row, including padding.
+    /// \param columns Width of the image in pixels.
+    /// \param rows Height of the image in pixels.
+    /// \param bitsPerPixel Number of bits of a single pixel, needed for tiles.
+    MemXferWriter(RowFunc rowFunc, UInt32 bytesPerRow, UInt32 columns, UInt32 rows, UInt16 bitsPerPixel) :
+        m_first(nullptr), m_stride(0), m_rowFunc(std::move(rowFunc)), m_bytesPerRow(bytesPerRow), m_columns(columns),
+        m_rows(rows), m_bitsPerPixel(bitsPerPixel), m_tiles(false), m_tileColumns(0), m_tileRows(0), m_x(0), m_y(0){}
+
+    /// Enables tiled transfer, see CapType::ITiles.
+    /// Takes effect with the next image, see `reset`.
+    void setTiles(bool tiles) noexcept{
+        m_tiles = tiles;
+    }
+
+    /// Whether tiled transfer is enabled.
+    bool tiles() const noexcept{
+        return m_tiles;
+    }
+
+    /// Starts the transfer of the image again.
+    void reset() noexcept{
+        m_x = 0;
+        m_y = 0;
+        m_tileColumns = 0;
+        m_tileRows = 0;
+    }
+
+    /// Whether the whole image was written.
+    bool done() const noexcept{
+        return m_y >= m_rows;
+    }
+
+    /// Number of whole rows written so far.
+    UInt32 rowsWritten() const noexcept{
+        return std::min(m_y, m_rows);
+    }
+
+    /// Writes next rows or tile into the memory transfer.
+    /// \param data Memory transfer, the memory must be provided by the application.
+    /// \param setup Memory transfer setup the buffer is checked against.
+    /// \return Success, XferDone after the last rows, SeqError if the image was already written,
+    ///         BadValue if the buffer size is out of setup limits or can not hold a single row or tile.
+    Result write(Detail::ImageMemXferImpl& data, const SetupMemXfer& setup){
+        auto size = data.memory().size();
+        if (size > setup.maxSize() || size < setup.minSize()){
+            return {ReturnCode::Failure, ConditionCode::BadValue};
+        }
+
+        return write(data);
+    }
+
+    /// Writes next rows or tile into the memory transfer.
+    /// \param data Memory transfer, the memory must be provided by the application.
+    /// \return Success, XferDone after the last rows, SeqError if the image was already written,
+    ///         BadValue if the buffer can not hold a single row or tile.
+    Result write(Detail::ImageMemXferImpl& data){
+        if (done() || m_bytesPerRow == 0 || (!m_first && !m_rowFunc)){
+            return {ReturnCode::Failure, ConditionCode::SeqError};
+        }
+
+        auto ok = m_tiles ? writeTile(data) : writeStrip(data);
+        if (!ok){
+            return {ReturnCode::Failure, ConditionCode::BadValue};
+        }
+
+        if (done()){
+            return {ReturnCode::XferDone, ConditionCode::Success};
+        }
+
+        return {ReturnCode::Success, ConditionCode::Success};
+    }
+
+private:
+    const char* row(UInt32 y) const{
+        return m_first ? m_first + static_cast<std::ptrdiff_t>(y) * m_stride : m_rowFunc(y);
+    }
+
+    /// Copies `rows` rows starting at `x` bytes into `out`.
+    void copyRows(char* out, UInt32 outStride, UInt32 y, UInt32 rows, UInt32 x, UInt32 bytes) const{
+        if (m_first && x == 0 && bytes == outStride && m_stride == static_cast<Int32>(outStride)){
+            // contiguous on both sides
+            std::memcpy(out, row(y), static_cast<std::size_t>(rows) * bytes);
+            return;
+        }
+
+        for (UInt32 i = 0; i < rows; i++){
+            std::memcpy(out + static_cast<std::size_t>(i) * outStride, row(y + i) + x, bytes);
+        }
+    }
+
+    bool writeStrip(Detail::ImageMemXferImpl& data){
+        auto rows = std::min(data.memory().size() / m_bytesPerRow, m_rows - m_y);
+        if (rows == 0){
+            return false;
+        }
+
+        {
+            auto lock = data.memory().data();
+            copyRows(lock.data(), m_bytesPerRow, m_y, rows, 0, m_bytesPerRow);
+        }
+
+        data.setCompression(Compression::None);
+        data.setBytesPerRow(m_bytesPerRow);
+        data.setColumns(m_columns);
+        data.setRows(rows);
+        data.setXOffset(0);
+        data.setYOffset(m_y);
+        data.setBytesWritten(rows * m_bytesPerRow);
+
+        m_y += rows;
+        return true;
+    }
+
+    static UInt32 tileBytes(UInt32 columns, UInt16 bitsPerPixel) noexcept{
+        return static_cast<UInt32>((static_cast<UInt64>(columns) * bitsPerPixel + 7) / 8);
+    }
+
+    bool writeTile(Detail::ImageMemXferImpl& data){
+        assert(m_bitsPerPixel != 0);
+        auto size = data.memory().size();
+
+        if (m_tileColumns == 0){
+            // the first tile fixes the grid, roughly square tiles starting on whole bytes
+            UInt32 align = m_bitsPerPixel < 8 ? 8 / m_bitsPerPixel : 1;
+            auto side = static_cast<UInt32>(std::sqrt(static_cast<double>(size) * 8 / m_bitsPerPixel));
+            auto columns = std::min(side / align * align, m_columns);
+            if (columns == 0){
+                return false;
+            }
+
+            auto rows = std::min(size / tileBytes(columns, m_bitsPerPixel), m_rows);
+            if (rows == 0){
+                return false;
+            }
+
+            m_tileColumns = columns;
+            m_tileRows = rows;
+        }
+
+        auto columns = std::min(m_tileColumns, m_columns - m_x);
+        auto rows = std::min(m_tileRows, m_rows - m_y);
+        auto bytesPerRow = tileBytes(columns, m_bitsPerPixel);
+        if (rows == 0 || static_cast<UInt64>(rows) * bytesPerRow > size){
+            return false;
+        }
+
+        {
+            auto lock = data.memory().data();
+            copyRows(lock.data(), bytesPerRow, m_y, rows, tileBytes(m_x, m_bitsPerPixel), bytesPerRow);
+        }
+
+        data.setCompression(Compression::None);
+        data.setBytesPerRow(bytesPerRow);
+        data.setColumns(columns);
+        data.setRows(rows);
+        data.setXOffset(m_x);
+        data.setYOffset(m_y);
+        data.setBytesWritten(rows * bytesPerRow);
+
+        // left to right, top to bottom
+        m_x += columns;
+        if (m_x >= m_columns){
+            m_x = 0;
+            m_y += rows;
+        }
+
+        return true;
+    }
+
+    const char* m_first;
+    Int32 m_stride;
+    RowFunc m_rowFunc;
+    UInt32 m_bytesPerRow;
+    UInt32 m_columns;
+    UInt32 m_rows;
+    UInt16 m_bitsPerPixel;
+    bool m_tiles;
+    UInt32 m_tileColumns;
+    UInt32 m_tileRows;
+    UInt32 m_x;
+    UInt32 m_y;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_MEMXFERWRITER_HPP
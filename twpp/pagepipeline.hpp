@@ -0,0 +1,368 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_PAGEPIPELINE_HPP
+#define TWPP_DETAIL_FILE_PAGEPIPELINE_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// Failure of the device while preparing a page, e.g. a paper jam.
+/// Thrown by PagePipeline producers, reported to the application with its condition code.
+class PageException : public Exception {
+
+public:
+    explicit PageException(ConditionCode cc = ConditionCode::OperationError) noexcept :
+        m_cc(cc){}
+
+    virtual const char* what() const noexcept override{
+        return "Failed to prepare a page.";
+    }
+
+    /// Condition code reported to the application.
+    ConditionCode conditionCode() const noexcept{
+        return m_cc;
+    }
+
+private:
+    ConditionCode m_cc;
+
+};
+
+/// Multi-page transfer pipeline of a data source.
+/// A background thread prepares the next pages (scanning, image processing)
+/// while the current page is being transferred, the number of pages prepared ahead is bounded.
+/// Tracks the CapType::XferCount limit and answers PendingXfers calls.
+///
+/// Usage:
+///  - `start` once the scan begins, e.g. before `notifyXferReady`,
+///  - `current` from transfer calls (ImageInfo, ImageMemXfer, ImageNativeXfer, ...),
+///  - `end`, `reset`, `stopFeeder` and `get` from the matching PendingXfers calls,
+///  - `cancel` from `userInterfaceDisable`.
+///
+/// Transfer calls wait only when the device is slower than the application,
+/// EndXfer waits until it is known whether another page follows, so that the reported count is correct.
+/// If the producer throws after some pages were prepared, the PendingXfers call following the last
+/// of them fails, PageException reports its condition code, std::bad_alloc LowMemory, others Bummer.
+/// \tparam Page Type of a single prepared page, must be default-constructible and movable.
+template<typename Page>
+class PagePipeline {
+
+public:
+    /// Pipeline statistics.
+    class Stats {
+
+    public:
+        constexpr Stats() noexcept :
+            m_producerWaits(0), m_consumerWaits(0){}
+
+        constexpr Stats(UInt64 producerWaits, UInt64 consumerWaits) noexcept :
+            m_producerWaits(producerWaits), m_consumerWaits(consumerWaits){}
+
+        /// Number of times the device thread waited for the application to transfer a page.
+        constexpr UInt64 producerWaits() const noexcept{
+            return m_producerWaits;
+        }
+
+        /// Number of times a transfer call waited for the device.
+        constexpr UInt64 consumerWaits() const noexcept{
+            return m_consumerWaits;
+        }
+
+    private:
+        UInt64 m_producerWaits;
+        UInt64 m_consumerWaits;
+
+    };
+
+    /// Prepares a single page, called on the background thread.
+    /// May throw PageException to report a device failure.
+    /// \param index Zero-based index of the page within this scan.
+    /// \param page Page to fill.
+    /// \param patch Set to the job separator detected after this page, reported by EndXfer of the page.
+    /// \return False if there are no more pages, e.g. the feeder is empty.
+    typedef std::function<bool(UInt32 index, Page& page, PendingXfers::JobPatch& patch)> Producer;
+
+    /// Creates idle pipeline.
+    /// \param prefetch Number of pages prepared ahead of the current one, at least 1.
+    explicit PagePipeline(UInt32 prefetch = 1) :
+        m_prefetch(std::max<UInt32>(prefetch, 1)){}
+
+    PagePipeline(const PagePipeline&) = delete;
+    PagePipeline& operator=(const PagePipeline&) = delete;
+
+    ~PagePipeline(){
+        cancel();
+    }
+
+    /// Starts preparing pages, cancels the previous scan if any.
+    /// \param xferCount Value of CapType::XferCount, -1 for all pages the device provides.
+    /// \param producer Function preparing the pages.
+    void start(Int16 xferCount, Producer producer){
+        cancel();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pages.clear();
+        m_limit = xferCount > 0 ? static_cast<UInt32>(xferCount) : std::numeric_limits<UInt32>::max();
+        m_transferred = 0;
+        m_finished = false;
+        m_stopped = false;
+        m_cancelled = false;
+        m_error = nullptr;
+        m_thread = std::thread(&PagePipeline::run, this, std::move(producer));
+    }
+
+    /// The page being transferred, waits until it is prepared.
+    /// The pointer stays valid until `end`, `reset` or `cancel`.
+    /// Rethrows the exception of the producer once all prepared pages were transferred.
+    /// \return Null if there is no page.
+    Page* current(){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_pages.empty() && !m_finished){
+            m_consumerWaits++;
+            m_ready.wait(lock, [this](){
+                return !m_pages.empty() || m_finished;
+            });
+        }
+
+        if (m_pages.empty()){
+            if (m_error){
+                auto error = m_error;
+                m_error = nullptr;
+                std::rethrow_exception(error);
+            }
+
+            return nullptr;
+        }
+
+        return &m_pages.front().m_page;
+    }
+
+    /// PendingXfers MSG_GET.
+    /// The count is -1 while the number of remaining pages is not known.
+    /// Fails once all prepared pages were transferred and the producer failed.
+    Result get(PendingXfers& data) const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        data.setCount(pendingCount());
+        data.setJobPatch(PendingXfers::JobPatch::None);
+        return m_pages.empty() && m_error ? failure(m_error) : success();
+    }
+
+    /// PendingXfers MSG_ENDXFER, drops the current page.
+    /// Waits until the next page is prepared or the device runs out of pages.
+    /// Fails if the producer failed instead of preparing the next page.
+    Result end(PendingXfers& data){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto patch = PendingXfers::JobPatch::None;
+        if (!m_pages.empty()){
+            patch = m_pages.front().m_patch;
+            m_pages.pop_front();
+            m_transferred++;
+            m_notFull.notify_all();
+        }
+
+        if (m_pages.empty() && !m_finished){
+            m_consumerWaits++;
+            m_ready.wait(lock, [this](){
+                return !m_pages.empty() || m_finished;
+            });
+        }
+
+        data.setCount(pendingCount());
+        data.setJobPatch(patch);
+        return takeError();
+    }
+
+    /// PendingXfers MSG_RESET, drops all pages and stops the device thread.
+    Result reset(PendingXfers& data){
+        cancel();
+        data.setCount(0);
+        data.setJobPatch(PendingXfers::JobPatch::None);
+        return success();
+    }
+
+    /// PendingXfers MSG_STOPFEEDER, no more pages are started.
+    /// The page the device is working on is finished and transferred as usual.
+    /// Fails if the producer failed and there are no pages left to transfer.
+    Result stopFeeder(PendingXfers& data){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_notFull.notify_all();
+        m_ready.wait(lock, [this](){
+            return m_finished;
+        });
+
+        data.setCount(pendingCount());
+        data.setJobPatch(PendingXfers::JobPatch::None);
+        return takeError();
+    }
+
+    /// Drops all pages and waits for the device thread to exit.
+    /// The producer may check `cancelled` to abort the current page early.
+    void cancel(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cancelled = true;
+            m_pages.clear();
+            m_notFull.notify_all();
+            m_ready.notify_all();
+        }
+
+        if (m_thread.joinable()){
+            m_thread.join();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+    }
+
+    /// Whether the scan was cancelled, meant for the producer.
+    bool cancelled() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_cancelled;
+    }
+
+    /// Number of pages ended by PendingXfers MSG_ENDXFER since `start`.
+    UInt32 transferred() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_transferred;
+    }
+
+    Stats stats() const{
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return {m_producerWaits, m_consumerWaits};
+    }
+
+private:
+    struct Entry {
+        Page m_page;
+        PendingXfers::JobPatch m_patch = PendingXfers::JobPatch::None;
+    };
+
+    static constexpr Result success() noexcept{
+        return {ReturnCode::Success, ConditionCode::Success};
+    }
+
+    /// Maps exception of the producer to the result reported to the application.
+    static Result failure(const std::exception_ptr& error) noexcept{
+        try {
+            std::rethrow_exception(error);
+        } catch (const PageException& e){
+            return {ReturnCode::Failure, e.conditionCode()};
+        } catch (const std::bad_alloc&){
+            return {ReturnCode::Failure, ConditionCode::LowMemory};
+        } catch (...){
+            return {ReturnCode::Failure, ConditionCode::Bummer};
+        }
+    }
+
+    /// Reports the exception of the producer once there are no pages left, only once.
+    /// Expects locked mutex.
+    Result takeError() noexcept{
+        if (!m_pages.empty() || !m_error){
+            return success();
+        }
+
+        auto rc = failure(m_error);
+        m_error = nullptr;
+        return rc;
+    }
+
+    /// Remaining pages including the current one, -1 if unknown.
+    /// Expects locked mutex.
+    UInt16 pendingCount() const noexcept{
+        if (m_finished){
+            return static_cast<UInt16>(m_pages.size());
+        }
+
+        if (m_limit != std::numeric_limits<UInt32>::max()){
+            return static_cast<UInt16>(m_limit - m_transferred);
+        }
+
+        return static_cast<UInt16>(-1);
+    }
+
+    /// Waits until another page may be prepared.
+    /// \return Whether page `index` should be prepared.
+    bool waitForSlot(UInt32 index){
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_pages.size() > m_prefetch && !m_stopped && !m_cancelled){
+            m_producerWaits++;
+            m_notFull.wait(lock, [this](){
+                return m_pages.size() <= m_prefetch || m_stopped || m_cancelled;
+            });
+        }
+
+        return !m_stopped && !m_cancelled && index < m_limit;
+    }
+
+    void run(Producer producer){
+        for (UInt32 index = 0; waitForSlot(index); index++){
+            Entry entry;
+            bool ok = false;
+            try {
+                ok = producer(index, entry.m_page, entry.m_patch);
+            } catch (...){
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!ok || m_cancelled){
+                break;
+            }
+
+            m_pages.push_back(std::move(entry));
+            m_ready.notify_all();
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+        m_ready.notify_all();
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_ready;
+    std::deque<Entry> m_pages; // front is the current page, references stay valid on push_back
+    std::thread m_thread;
+    UInt32 m_prefetch;
+    UInt32 m_limit = 0;
+    UInt32 m_transferred = 0;
+    bool m_finished = true;
+    bool m_stopped = false;
+    bool m_cancelled = false;
+    std::exception_ptr m_error;
+
+    UInt64 m_producerWaits = 0;
+    UInt64 m_consumerWaits = 0;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_PAGEPIPELINE_HPP
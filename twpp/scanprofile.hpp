@@ -0,0 +1,621 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_SCANPROFILE_HPP
+#define TWPP_DETAIL_FILE_SCANPROFILE_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+/// Invalid or unsupported scan profile data.
+class ScanProfileException : public Exception {
+
+public:
+    virtual const char* what() const noexcept override{
+        return "Invalid scan profile data.";
+    }
+
+};
+
+namespace Detail {
+
+class ProfileWriter {
+
+public:
+    explicit ProfileWriter(std::vector<char>& out) noexcept :
+        m_out(out){}
+
+    template<typename T>
+    void put(const T& value){
+        bytes(&value, sizeof(T));
+    }
+
+    void bytes(const void* data, std::size_t size){
+        auto begin = static_cast<const char*>(data);
+        m_out.insert(m_out.end(), begin, begin + size);
+    }
+
+    void memory(const Memory& mem){
+        put<UInt32>(mem.size());
+        if (mem.size() != 0){
+            bytes(mem.data().data(), mem.size());
+        }
+    }
+
+private:
+    std::vector<char>& m_out;
+
+};
+
+class ProfileReader {
+
+public:
+    ProfileReader(const char* data, std::size_t size) noexcept :
+        m_cur(data), m_end(data + size){}
+
+    template<typename T>
+    T get(){
+        T value;
+        bytes(&value, sizeof(T));
+        return value;
+    }
+
+    void bytes(void* out, std::size_t size){
+        if (static_cast<std::size_t>(m_end - m_cur) < size){
+            throw ScanProfileException();
+        }
+
+        std::memcpy(out, m_cur, size);
+        m_cur += size;
+    }
+
+    Memory memory(){
+        auto size = get<UInt32>();
+        check(size);
+
+        Memory mem(size);
+        if (size != 0){
+            bytes(mem.data().data(), size);
+        }
+
+        return mem;
+    }
+
+    bool atEnd() const noexcept{
+        return m_cur == m_end;
+    }
+
+    /// Makes sure that the blob contains at least `size` more bytes,
+    /// to be called before allocating memory for them.
+    void check(std::size_t size) const{
+        if (static_cast<std::size_t>(m_end - m_cur) < size){
+            throw ScanProfileException();
+        }
+    }
+
+private:
+    const char* m_cur;
+    const char* m_end;
+
+};
+
+}
+
+/// Negotiated state of a source: current values of settable capabilities,
+/// image layout, JPEG compression and custom DS data.
+/// Profiles are captured once, stored as binary blobs, and applied to a source
+/// with as few DSM calls as possible.
+///
+/// The binary format is versioned, values are stored in native byte order,
+/// blobs of the other byte order are rejected.
+class ScanProfile {
+
+public:
+    /// Current version of the binary format.
+    static constexpr const UInt16 formatVersion = 1;
+
+    /// Creates empty profile.
+    ScanProfile() noexcept :
+        m_hasLayout(false), m_hasJpeg(false), m_hasCustom(false){}
+
+    ScanProfile(ScanProfile&&) = default;
+    ScanProfile& operator=(ScanProfile&&) = default;
+
+    /// Captures the current state of an open source.
+    /// Only capabilities that support Set are included,
+    /// capabilities holding handles are left out.
+    /// \throw std::bad_alloc
+    static ScanProfile capture(Source& src){
+        ScanProfile ret;
+
+        Capability supported(CapType::SupportedCaps);
+        if (success(src.capability(Msg::Get, supported))){
+            for (auto cap : supported.array<CapType::SupportedCaps>()){
+                if (cap == CapType::SupportedCaps){
+                    continue;
+                }
+
+                Capability query(cap);
+                if (!success(src.capability(Msg::QuerySupport, query)) ||
+                        (query.currentItem<MsgSupport>() & MsgSupport::Set) == msgSupportEmpty){
+                    continue;
+                }
+
+                Capability current(cap);
+                if (src.capability(Msg::GetCurrent, current) == ReturnCode::Success &&
+                        current && current.itemType() != Type::Handle){
+                    ret.m_caps.emplace_back(std::move(current));
+                }
+            }
+        }
+
+        ret.m_hasLayout = success(src.imageLayout(Msg::Get, ret.m_layout));
+        ret.m_hasJpeg = success(src.jpegCompression(Msg::Get, ret.m_jpeg));
+        ret.m_hasCustom = success(src.customData(Msg::Get, ret.m_custom));
+        return ret;
+    }
+
+    /// Computes the profile that turns `current` into `target`.
+    /// Contains only capabilities of `target` whose values differ from `current`
+    /// or are missing there, ordered by their dependencies.
+    /// Image layout, JPEG compression and custom data are included when they differ.
+    /// Apply the result with `skipUnchanged = false`, no value needs to be compared again.
+    /// \throw std::bad_alloc
+    static ScanProfile diff(const ScanProfile& current, const ScanProfile& target){
+        std::unordered_map<UInt16, const Capability*> known;
+        known.reserve(current.m_caps.size());
+        for (const auto& cap : current.m_caps){
+            known.emplace(static_cast<UInt16>(cap.type()), &cap);
+        }
+
+        ScanProfile ret;
+        for (const auto& cap : target.m_caps){
+            auto it = known.find(static_cast<UInt16>(cap.type()));
+            bool same = false;
+            if (it != known.end()){
+                try {
+                    same = it->second->sameValues(cap);
+                } catch (const Exception&){
+                    // invalid data, let the source decide
+                }
+            }
+
+            if (!same){
+                ret.m_caps.emplace_back(cap.clone());
+            }
+        }
+
+        std::stable_sort(ret.m_caps.begin(), ret.m_caps.end(), [](const Capability& a, const Capability& b){
+            return Detail::negotiationRank(a.type()) < Detail::negotiationRank(b.type());
+        });
+
+        if (target.m_hasLayout && (!current.m_hasLayout || !sameLayout(current.m_layout, target.m_layout))){
+            ret.setImageLayout(target.m_layout);
+        }
+
+        if (target.m_hasJpeg && (!current.m_hasJpeg || !sameJpeg(current.m_jpeg, target.m_jpeg))){
+            auto& jpeg = ret.m_jpeg;
+            jpeg.setPixelType(target.m_jpeg.pixelType());
+            jpeg.setSubSampling(target.m_jpeg.subSampling());
+            jpeg.setComponents(target.m_jpeg.components());
+            jpeg.setRestartFrequency(target.m_jpeg.restartFrequency());
+            std::memcpy(jpeg.quantTableMap(), target.m_jpeg.quantTableMap(), sizeof(JpegCompression::UInt16Arr4));
+            std::memcpy(jpeg.huffmanTableMap(), target.m_jpeg.huffmanTableMap(), sizeof(JpegCompression::UInt16Arr4));
+            for (std::size_t i = 0; i < 4; i++){
+                jpeg.quantTable()[i] = copyMemory(target.m_jpeg.quantTable()[i]);
+            }
+
+            for (std::size_t i = 0; i < 2; i++){
+                jpeg.huffmanDc()[i] = copyMemory(target.m_jpeg.huffmanDc()[i]);
+                jpeg.huffmanAc()[i] = copyMemory(target.m_jpeg.huffmanAc()[i]);
+            }
+
+            ret.m_hasJpeg = true;
+        }
+
+        if (target.m_hasCustom && (!current.m_hasCustom || !sameCustom(current.m_custom, target.m_custom))){
+            CustomData custom(target.m_custom.size());
+            if (custom.size() != 0){
+                std::memcpy(custom.lock<char>().data(), target.m_custom.lock<char>().data(), custom.size());
+            }
+
+            ret.setCustomData(std::move(custom));
+        }
+
+        return ret;
+    }
+
+    /// Whether applying the profile would change nothing.
+    bool empty() const noexcept{
+        return m_caps.empty() && !m_hasLayout && !m_hasJpeg && !m_hasCustom;
+    }
+
+    /// Applies the profile to an open source.
+    /// Capabilities are set through `Source::negotiate`.
+    /// \param results Optional output of per-capability results.
+    /// \param skipUnchanged Whether to skip capabilities whose current value already matches.
+    /// \return Success if everything was applied, otherwise the first failure.
+    /// \throw std::bad_alloc
+    ReturnCode apply(Source& src, std::vector<NegotiationResult>* results = nullptr, bool skipUnchanged = true){
+        auto rc = ReturnCode::Success;
+        auto merge = [&rc](ReturnCode r){
+            if (rc == ReturnCode::Success && !success(r)){
+                rc = r;
+            }
+        };
+
+        auto res = src.negotiate(m_caps, false, skipUnchanged);
+        for (auto& r : res){
+            merge(r.returnCode());
+        }
+
+        if (m_hasLayout){
+            auto layout = m_layout;
+            merge(src.imageLayout(Msg::Set, layout));
+        }
+
+        if (m_hasJpeg){
+            merge(src.jpegCompression(Msg::Set, m_jpeg));
+        }
+
+        if (m_hasCustom){
+            merge(src.customData(Msg::Set, m_custom));
+        }
+
+        if (results){
+            *results = std::move(res);
+        }
+
+        return rc;
+    }
+
+    /// Serializes the profile into a binary blob.
+    /// \throw std::bad_alloc
+    std::vector<char> serialize() const{
+        std::vector<char> out;
+        Detail::ProfileWriter w(out);
+
+        w.bytes(magic(), 4);
+        w.put<UInt16>(static_cast<UInt16>(formatVersion));
+        w.put<UInt16>(static_cast<UInt16>(byteOrderMark));
+        w.put<UInt16>(static_cast<UInt16>((m_hasLayout ? hasLayout : 0) |
+                                          (m_hasJpeg ? hasJpeg : 0) |
+                                          (m_hasCustom ? hasCustom : 0)));
+        w.put<UInt32>(static_cast<UInt32>(m_caps.size()));
+
+        for (const auto& cap : m_caps){
+            w.put<UInt16>(static_cast<UInt16>(cap.type()));
+            w.put<UInt16>(static_cast<UInt16>(cap.container()));
+            if (!cap){
+                w.put<UInt32>(0);
+                continue;
+            }
+
+            auto size = static_cast<UInt32>(cap.dataSize(cap.itemType(), false));
+            w.put<UInt32>(size);
+            w.bytes(cap.m_cont.lock<char>().data(), size);
+        }
+
+        if (m_hasLayout){
+            const auto& f = m_layout.frame();
+            for (auto v : {f.left(), f.top(), f.right(), f.bottom()}){
+                w.put<Int16>(v.whole());
+                w.put<UInt16>(v.frac());
+            }
+
+            w.put<UInt32>(m_layout.documentNumber());
+            w.put<UInt32>(m_layout.pageNumber());
+            w.put<UInt32>(m_layout.frameNumber());
+        }
+
+        if (m_hasJpeg){
+            w.put<UInt16>(static_cast<UInt16>(m_jpeg.pixelType()));
+            w.put<UInt32>(m_jpeg.subSampling());
+            w.put<UInt16>(m_jpeg.components());
+            w.put<UInt16>(m_jpeg.restartFrequency());
+            w.bytes(m_jpeg.quantTableMap(), sizeof(JpegCompression::UInt16Arr4));
+            for (const auto& mem : m_jpeg.quantTable()){
+                w.memory(mem);
+            }
+
+            w.bytes(m_jpeg.huffmanTableMap(), sizeof(JpegCompression::UInt16Arr4));
+            for (const auto& mem : m_jpeg.huffmanDc()){
+                w.memory(mem);
+            }
+
+            for (const auto& mem : m_jpeg.huffmanAc()){
+                w.memory(mem);
+            }
+        }
+
+        if (m_hasCustom){
+            w.put<UInt32>(m_custom.size());
+            if (m_custom.size() != 0){
+                w.bytes(m_custom.lock<char>().data(), m_custom.size());
+            }
+        }
+
+        return out;
+    }
+
+    /// Restores profile from a binary blob.
+    /// \throw ScanProfileException When the data are malformed, of other version or byte order.
+    /// \throw std::bad_alloc
+    static ScanProfile deserialize(const void* data, std::size_t size){
+        Detail::ProfileReader r(static_cast<const char*>(data), size);
+
+        char mag[4];
+        r.bytes(mag, 4);
+        if (std::memcmp(mag, magic(), 4) != 0 ||
+                r.get<UInt16>() != formatVersion ||
+                r.get<UInt16>() != byteOrderMark){
+            throw ScanProfileException();
+        }
+
+        auto flags = r.get<UInt16>();
+        auto count = r.get<UInt32>();
+
+        ScanProfile ret;
+        ret.m_caps.reserve(std::min<std::size_t>(count, size));
+        for (UInt32 i = 0; i < count; i++){
+            auto cap = static_cast<CapType>(r.get<UInt16>());
+            auto conType = static_cast<ConType>(r.get<UInt16>());
+            auto capSize = r.get<UInt32>();
+            if (capSize == 0){
+                ret.m_caps.emplace_back(cap);
+                continue;
+            }
+
+            // item count must be present before the size is computed from it
+            std::size_t header = conType == ConType::Array ? sizeof(Type) + sizeof(UInt32) :
+                                 conType == ConType::Enumeration ? sizeof(Type) + 3 * sizeof(UInt32) :
+                                 sizeof(Type);
+            if (capSize < header){
+                throw ScanProfileException();
+            }
+
+            r.check(capSize);
+
+            Type twty;
+            r.bytes(&twty, sizeof(Type));
+            try {
+                Capability c(cap, conType, twty, capSize);
+                r.bytes(c.m_cont.lock<char>().data() + sizeof(Type), capSize - sizeof(Type));
+                if (twty == Type::Handle || c.dataSize(twty, false) != capSize){
+                    throw ScanProfileException();
+                }
+
+                if (conType == ConType::Enumeration){
+                    auto enm = c.m_cont.lock<Detail::EnumerationData<UInt8> >();
+                    if (enm->m_currIndex >= enm->m_numItems || enm->m_defIndex >= enm->m_numItems){
+                        throw ScanProfileException();
+                    }
+                }
+
+                ret.m_caps.emplace_back(std::move(c));
+            } catch (const CapabilityException&){
+                throw ScanProfileException();
+            } catch (const TypeException&){
+                throw ScanProfileException();
+            }
+        }
+
+        if (flags & hasLayout){
+            Fix32 v[4];
+            for (auto& f : v){
+                auto whole = r.get<Int16>();
+                f = Fix32(whole, r.get<UInt16>());
+            }
+
+            auto doc = r.get<UInt32>();
+            auto page = r.get<UInt32>();
+            auto frame = r.get<UInt32>();
+            ret.m_layout = ImageLayout(Frame(v[0], v[1], v[2], v[3]), doc, page, frame);
+            ret.m_hasLayout = true;
+        }
+
+        if (flags & hasJpeg){
+            auto& jpeg = ret.m_jpeg;
+            jpeg.setPixelType(static_cast<PixelType>(r.get<UInt16>()));
+            jpeg.setSubSampling(r.get<UInt32>());
+            jpeg.setComponents(r.get<UInt16>());
+            jpeg.setRestartFrequency(r.get<UInt16>());
+            r.bytes(jpeg.quantTableMap(), sizeof(JpegCompression::UInt16Arr4));
+            for (auto& mem : jpeg.quantTable()){
+                mem = r.memory();
+            }
+
+            r.bytes(jpeg.huffmanTableMap(), sizeof(JpegCompression::UInt16Arr4));
+            for (auto& mem : jpeg.huffmanDc()){
+                mem = r.memory();
+            }
+
+            for (auto& mem : jpeg.huffmanAc()){
+                mem = r.memory();
+            }
+
+            ret.m_hasJpeg = true;
+        }
+
+        if (flags & hasCustom){
+            auto customSize = r.get<UInt32>();
+            r.check(customSize);
+
+            CustomData custom(customSize);
+            if (custom.size() != 0){
+                r.bytes(custom.lock<char>().data(), custom.size());
+            }
+
+            ret.m_custom = std::move(custom);
+            ret.m_hasCustom = true;
+        }
+
+        if (!r.atEnd()){
+            throw ScanProfileException();
+        }
+
+        return ret;
+    }
+
+    /// Restores profile from a binary blob.
+    /// \throw ScanProfileException When the data are malformed, of other version or byte order.
+    /// \throw std::bad_alloc
+    static ScanProfile deserialize(const std::vector<char>& data){
+        return deserialize(data.data(), data.size());
+    }
+
+    /// Capability values, set in dependency order when applied.
+    std::vector<Capability>& capabilities() noexcept{
+        return m_caps;
+    }
+
+    /// Capability values, set in dependency order when applied.
+    const std::vector<Capability>& capabilities() const noexcept{
+        return m_caps;
+    }
+
+    /// Whether the profile contains image layout.
+    bool hasImageLayout() const noexcept{
+        return m_hasLayout;
+    }
+
+    /// Image layout, valid if `hasImageLayout`.
+    const ImageLayout& imageLayout() const noexcept{
+        return m_layout;
+    }
+
+    /// Sets image layout to apply.
+    void setImageLayout(const ImageLayout& layout) noexcept{
+        m_layout = layout;
+        m_hasLayout = true;
+    }
+
+    /// Whether the profile contains JPEG compression.
+    bool hasJpegCompression() const noexcept{
+        return m_hasJpeg;
+    }
+
+    /// JPEG compression, valid if `hasJpegCompression`.
+    const JpegCompression& jpegCompression() const noexcept{
+        return m_jpeg;
+    }
+
+    /// Sets JPEG compression to apply.
+    void setJpegCompression(JpegCompression jpeg) noexcept{
+        m_jpeg = std::move(jpeg);
+        m_hasJpeg = true;
+    }
+
+    /// Whether the profile contains custom DS data.
+    bool hasCustomData() const noexcept{
+        return m_hasCustom;
+    }
+
+    /// Custom DS data, valid if `hasCustomData`.
+    const CustomData& customData() const noexcept{
+        return m_custom;
+    }
+
+    /// Sets custom DS data to apply.
+    void setCustomData(CustomData custom) noexcept{
+        m_custom = std::move(custom);
+        m_hasCustom = true;
+    }
+
+private:
+    static constexpr const UInt16 byteOrderMark = 0x0102;
+
+    static constexpr const UInt16 hasLayout = 0x0001;
+    static constexpr const UInt16 hasJpeg = 0x0002;
+    static constexpr const UInt16 hasCustom = 0x0004;
+
+    static const char* magic() noexcept{
+        return "TWPF";
+    }
+
+    static bool sameLayout(const ImageLayout& a, const ImageLayout& b) noexcept{
+        return a.frame() == b.frame() && a.documentNumber() == b.documentNumber() &&
+                a.pageNumber() == b.pageNumber() && a.frameNumber() == b.frameNumber();
+    }
+
+    static bool sameMemory(const Memory& a, const Memory& b) noexcept{
+        return a.size() == b.size() &&
+                (a.size() == 0 || std::memcmp(a.data().data(), b.data().data(), a.size()) == 0);
+    }
+
+    static bool sameJpeg(const JpegCompression& a, const JpegCompression& b) noexcept{
+        if (a.pixelType() != b.pixelType() || a.subSampling() != b.subSampling() ||
+                a.components() != b.components() || a.restartFrequency() != b.restartFrequency() ||
+                std::memcmp(a.quantTableMap(), b.quantTableMap(), sizeof(JpegCompression::UInt16Arr4)) != 0 ||
+                std::memcmp(a.huffmanTableMap(), b.huffmanTableMap(), sizeof(JpegCompression::UInt16Arr4)) != 0){
+            return false;
+        }
+
+        for (std::size_t i = 0; i < 4; i++){
+            if (!sameMemory(a.quantTable()[i], b.quantTable()[i])){
+                return false;
+            }
+        }
+
+        for (std::size_t i = 0; i < 2; i++){
+            if (!sameMemory(a.huffmanDc()[i], b.huffmanDc()[i]) || !sameMemory(a.huffmanAc()[i], b.huffmanAc()[i])){
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static bool sameCustom(const CustomData& a, const CustomData& b) noexcept{
+        return a.size() == b.size() &&
+                (a.size() == 0 || std::memcmp(a.lock<char>().data(), b.lock<char>().data(), a.size()) == 0);
+    }
+
+    /// \throw std::bad_alloc
+    static Memory copyMemory(const Memory& mem){
+        Memory ret(mem.size());
+        if (mem.size() != 0){
+            std::memcpy(ret.data().data(), mem.data().data(), mem.size());
+        }
+
+        return ret;
+    }
+
+    std::vector<Capability> m_caps;
+    ImageLayout m_layout;
+    JpegCompression m_jpeg;
+    CustomData m_custom;
+    bool m_hasLayout;
+    bool m_hasJpeg;
+    bool m_hasCustom;
+
+};
+
+}
+
+#endif // TWPP_DETAIL_FILE_SCANPROFILE_HPP
+
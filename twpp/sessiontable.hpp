@@ -0,0 +1,253 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_SESSIONTABLE_HPP
+#define TWPP_DETAIL_FILE_SESSIONTABLE_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+/// Objects indexed by ID, e.g. data source instances by application ID.
+/// Objects live in a slab of fixed-size chunks, they never move and their slots are reused after erase.
+/// The ID index is an open-addressed hash table with linear probing and backward-shift deletion,
+/// lookup costs the same regardless of the number of objects.
+/// \tparam T Object type, must be default-constructible, need not be movable.
+/// \tparam Key ID type, must be hashable by std::hash, e.g. Identity::Id.
+/// \tparam chunkSize Number of objects in a single slab chunk.
+template<typename T, typename Key = UInt32, UInt32 chunkSize = 16>
+class SessionTable {
+
+public:
+    /// Invalid slot.
+    static constexpr const UInt32 npos = std::numeric_limits<UInt32>::max();
+
+    SessionTable() = default;
+
+    SessionTable(const SessionTable&) = delete;
+    SessionTable& operator=(const SessionTable&) = delete;
+
+    ~SessionTable(){
+        for (UInt32 slot = 0; slot < m_used.size(); slot++){
+            if (m_used[slot]){
+                at(slot).~T();
+            }
+        }
+    }
+
+    /// Creates new object in a free slot, the object is not bound to any ID.
+    /// Reserves space for its ID, so that `bind` does not throw.
+    /// \return Slot of the object.
+    UInt32 emplace(){
+        if ((m_size + 1) * 2 > m_index.size()){
+            rehash(m_index.empty() ? 16 : m_index.size() * 2);
+        }
+
+        if (m_free.empty()){
+            std::unique_ptr<Chunk> chunk(new Chunk);
+            auto first = static_cast<UInt32>(m_chunks.size()) * chunkSize;
+            m_chunks.push_back(std::move(chunk));
+            m_used.resize(m_used.size() + chunkSize, false);
+            m_keys.resize(m_keys.size() + chunkSize, Key());
+            m_bound.resize(m_bound.size() + chunkSize, false);
+            for (UInt32 i = chunkSize; i > 0; i--){
+                m_free.push_back(first + i - 1);
+            }
+        }
+
+        auto slot = m_free.back();
+        new (&m_chunks[slot / chunkSize]->m_objects[slot % chunkSize]) T();
+        m_free.pop_back();
+        m_used[slot] = true;
+        m_size++;
+        return slot;
+    }
+
+    /// Binds ID to the object, `find(id)` returns its slot from now on.
+    /// The ID must not be bound to any other object.
+    void bind(UInt32 slot, Key id) noexcept{
+        unbind(slot);
+        insert(id, slot);
+        m_keys[slot] = id;
+        m_bound[slot] = true;
+        m_bindings++;
+    }
+
+    /// Destroys the object and frees its slot.
+    void erase(UInt32 slot) noexcept{
+        unbind(slot);
+        at(slot).~T();
+        m_used[slot] = false;
+        m_free.push_back(slot); // never reallocates, the free list once held every slot
+        m_size--;
+    }
+
+    /// Destroys all objects, keeps allocated memory.
+    void clear() noexcept{
+        for (UInt32 slot = 0; slot < m_used.size(); slot++){
+            if (m_used[slot]){
+                erase(slot);
+            }
+        }
+    }
+
+    /// Slot of the object bound to the ID, or npos.
+    UInt32 find(Key id) const noexcept{
+        if (m_bindings == 0){
+            return npos;
+        }
+
+        auto mask = m_index.size() - 1;
+        for (auto i = hash(id) & mask; ; i = (i + 1) & mask){
+            const auto& e = m_index[i];
+            if (e.m_slot == npos){
+                return npos;
+            }
+
+            if (e.m_id == id){
+                return e.m_slot;
+            }
+        }
+    }
+
+    /// Object in the slot.
+    T& at(UInt32 slot) noexcept{
+        return *reinterpret_cast<T*>(&m_chunks[slot / chunkSize]->m_objects[slot % chunkSize]);
+    }
+
+    /// Object in the slot.
+    const T& at(UInt32 slot) const noexcept{
+        return *reinterpret_cast<const T*>(&m_chunks[slot / chunkSize]->m_objects[slot % chunkSize]);
+    }
+
+    /// Whether any object satisfies the predicate.
+    template<typename Pred>
+    bool any(Pred pred) const{
+        for (UInt32 slot = 0; slot < m_used.size(); slot++){
+            if (m_used[slot] && pred(at(slot))){
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// Number of objects.
+    UInt32 size() const noexcept{
+        return m_size;
+    }
+
+    /// Whether there are no objects.
+    bool empty() const noexcept{
+        return m_size == 0;
+    }
+
+private:
+    struct Chunk {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_objects[chunkSize];
+    };
+
+    struct IndexEntry {
+        Key m_id;
+        UInt32 m_slot;
+    };
+
+    static std::size_t hash(Key id) noexcept{
+        // std::hash is usually identity, mix the bits so that consecutive IDs and pointers spread well
+        auto h = static_cast<UInt64>(std::hash<Key>()(id));
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+    }
+
+    void insert(Key id, UInt32 slot) noexcept{
+        auto mask = m_index.size() - 1;
+        auto i = hash(id) & mask;
+        while (m_index[i].m_slot != npos){
+            i = (i + 1) & mask;
+        }
+
+        m_index[i] = {id, slot};
+    }
+
+    void unbind(UInt32 slot) noexcept{
+        if (!m_bound[slot]){
+            return;
+        }
+
+        auto mask = m_index.size() - 1;
+        auto i = hash(m_keys[slot]) & mask;
+        while (m_index[i].m_slot != slot){
+            i = (i + 1) & mask;
+        }
+
+        // backward-shift deletion, no tombstones are left behind
+        for (auto j = (i + 1) & mask; m_index[j].m_slot != npos; j = (j + 1) & mask){
+            auto home = hash(m_index[j].m_id) & mask;
+            if (((j - home) & mask) >= ((j - i) & mask)){
+                m_index[i] = m_index[j];
+                i = j;
+            }
+        }
+
+        m_index[i] = {Key(), npos};
+        m_keys[slot] = Key();
+        m_bound[slot] = false;
+        m_bindings--;
+    }
+
+    void rehash(std::size_t size){
+        std::vector<IndexEntry> old(size, IndexEntry{Key(), npos});
+        old.swap(m_index);
+        for (const auto& e : old){
+            if (e.m_slot != npos){
+                insert(e.m_id, e.m_slot);
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    std::vector<bool> m_used;
+    std::vector<bool> m_bound;
+    std::vector<Key> m_keys;
+    std::vector<UInt32> m_free;
+    std::vector<IndexEntry> m_index;
+    UInt32 m_size = 0;
+    UInt32 m_bindings = 0;
+
+};
+
+template<typename T, typename Key, UInt32 chunkSize>
+constexpr const UInt32 SessionTable<T, Key, chunkSize>::npos;
+
+}
+
+}
+
+#endif // TWPP_DETAIL_FILE_SESSIONTABLE_HPP
@@ -0,0 +1,339 @@
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2015-2017 Martin Richter
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#ifndef TWPP_DETAIL_FILE_TRIPLETSTATS_HPP
+#define TWPP_DETAIL_FILE_TRIPLETSTATS_HPP
+
+#include "../twpp.hpp"
+
+namespace Twpp {
+
+namespace Detail {
+
+template<typename Dummy>
+struct TripletStatsData;
+
+}
+
+TWPP_DETAIL_PACK_BEGIN
+/// Per-triplet call statistics of a data source.
+/// Collected by sources compiled with TWPP_TRIPLET_STATS,
+/// read by sending this structure to the source as custom data type `TripletStats::dat()`:
+///
+/// std::vector<TripletStats::Entry> entries(64);
+/// TripletStats stats(entries.data(), entries.size());
+/// source.customBase(DataGroup::Control, TripletStats::dat(), Msg::Get, stats);
+///
+/// Msg::Get fills the entries, Msg::Reset fills the entries and restarts counting of the filled ones.
+/// Sources without statistics do not support the data type.
+class TripletStats {
+
+public:
+    /// Number of latency buckets.
+    /// Bucket N counts calls taking [2^N, 2^(N+1)) nanoseconds, the last one also all slower calls.
+    static constexpr const UInt32 bucketCount = 32;
+
+    /// Custom data type of the statistics.
+    static constexpr Dat dat() noexcept{
+        return static_cast<Dat>(0xFFF0);
+    }
+
+    /// Statistics of a single triplet.
+    class Entry {
+
+    public:
+        /// Creates empty entry.
+        constexpr Entry() noexcept :
+            m_dg(DataGroup::Control), m_dat(Dat::Null), m_msg(Msg::Null),
+            m_calls(0), m_failures(0), m_totalNs(0), m_maxNs(0), m_buckets(){}
+
+        /// Data group of the triplet.
+        constexpr DataGroup dataGroup() const noexcept{
+            return m_dg;
+        }
+
+        /// Data argument type of the triplet.
+        constexpr Dat dat() const noexcept{
+            return m_dat;
+        }
+
+        /// Message of the triplet.
+        constexpr Msg msg() const noexcept{
+            return m_msg;
+        }
+
+        /// Number of calls.
+        constexpr UInt64 calls() const noexcept{
+            return m_calls;
+        }
+
+        /// Number of calls returning ReturnCode::Failure.
+        constexpr UInt64 failures() const noexcept{
+            return m_failures;
+        }
+
+        /// Total time spent in the source in nanoseconds.
+        constexpr UInt64 totalNs() const noexcept{
+            return m_totalNs;
+        }
+
+        /// The slowest call in nanoseconds.
+        constexpr UInt64 maxNs() const noexcept{
+            return m_maxNs;
+        }
+
+        /// Average call in nanoseconds.
+        constexpr UInt64 meanNs() const noexcept{
+            return m_calls != 0 ? m_totalNs / m_calls : 0;
+        }
+
+        /// Number of calls in latency bucket, see TripletStats::bucketCount.
+        UInt32 bucket(UInt32 index) const noexcept{
+            return index < bucketCount ? m_buckets[index] : 0;
+        }
+
+        /// Upper bound of the latency of `fraction` of calls, in nanoseconds.
+        /// \param fraction E.g. 0.99 for 99th percentile.
+        UInt64 percentileNs(double fraction) const noexcept{
+            UInt64 total = 0;
+            for (UInt32 i = 0; i < bucketCount; i++){
+                total += m_buckets[i];
+            }
+
+            auto limit = static_cast<UInt64>(std::ceil(fraction * static_cast<double>(total)));
+            UInt64 sum = 0;
+            for (UInt32 i = 0; i < bucketCount - 1; i++){
+                sum += m_buckets[i];
+                if (sum >= limit){
+                    return UInt64(2) << i;
+                }
+            }
+
+            return m_maxNs;
+        }
+
+    private:
+        template<typename> friend struct Detail::TripletStatsData;
+
+        DataGroup m_dg;
+        Dat m_dat;
+        Msg m_msg;
+        UInt64 m_calls;
+        UInt64 m_failures;
+        UInt64 m_totalNs;
+        UInt64 m_maxNs;
+        UInt32 m_buckets[bucketCount];
+
+    };
+
+    /// Creates request without any entries, only `available` is filled.
+    constexpr TripletStats() noexcept :
+        m_entries(nullptr), m_capacity(0), m_size(0), m_available(0), m_dropped(0){}
+
+    /// Creates request filling at most `capacity` entries.
+    /// \param entries Application-owned entries.
+    /// \param capacity Number of entries.
+    constexpr TripletStats(Entry* entries, UInt32 capacity) noexcept :
+        m_entries(entries), m_capacity(capacity), m_size(0), m_available(0), m_dropped(0){}
+
+    /// Entries filled by the source.
+    Entry* begin() const noexcept{
+        return m_entries;
+    }
+
+    /// End of entries filled by the source.
+    Entry* end() const noexcept{
+        return m_entries + m_size;
+    }
+
+    /// Number of entries filled by the source.
+    constexpr UInt32 size() const noexcept{
+        return m_size;
+    }
+
+    /// Number of entries the application provided.
+    constexpr UInt32 capacity() const noexcept{
+        return m_capacity;
+    }
+
+    /// Number of triplets the source has statistics of, may be more than `size`.
+    constexpr UInt32 available() const noexcept{
+        return m_available;
+    }
+
+    /// Number of calls not counted because the source ran out of triplet slots.
+    constexpr UInt64 dropped() const noexcept{
+        return m_dropped;
+    }
+
+private:
+    template<typename> friend struct Detail::TripletStatsData;
+
+    Entry* m_entries;
+    UInt32 m_capacity;
+    UInt32 m_size;
+    UInt32 m_available;
+    UInt64 m_dropped;
+
+};
+TWPP_DETAIL_PACK_END
+
+#if defined(TWPP_IS_DS)
+namespace Detail {
+
+/// Lock-free storage of triplet statistics, see TripletStats.
+/// Triplets are kept in a fixed open-addressed table, slots are claimed by CAS and never released.
+template<typename Dummy>
+struct TripletStatsData {
+
+    static constexpr const UInt32 slotCount = 128;
+
+    struct Slot {
+        std::atomic<UInt64> m_key;
+        std::atomic<UInt64> m_calls;
+        std::atomic<UInt64> m_failures;
+        std::atomic<UInt64> m_totalNs;
+        std::atomic<UInt64> m_maxNs;
+        std::atomic<UInt32> m_buckets[TripletStats::bucketCount];
+    };
+
+    static Slot slots[slotCount];
+    static std::atomic<UInt64> dropped;
+
+    static UInt64 key(DataGroup dg, Dat dat, Msg msg) noexcept{
+        // the top bit marks used slot
+        return (UInt64(1) << 63) | ((static_cast<UInt64>(dg) & 0x7FFFFFFF) << 32) |
+                (static_cast<UInt64>(dat) << 16) | static_cast<UInt64>(msg);
+    }
+
+    static UInt32 bucket(UInt64 ns) noexcept{
+        // floor(log2(ns))
+        UInt32 index = 0;
+        for (UInt32 shift = 32; shift != 0; shift /= 2){
+            if (ns >> shift){
+                ns >>= shift;
+                index += shift;
+            }
+        }
+
+        return std::min(index, TripletStats::bucketCount - 1);
+    }
+
+    static Slot* find(UInt64 k) noexcept{
+        auto h = static_cast<UInt32>((k * 0x9E3779B97F4A7C15ull) >> 32);
+        for (UInt32 i = 0; i < slotCount; i++){
+            auto& slot = slots[(h + i) % slotCount];
+            auto current = slot.m_key.load(std::memory_order_acquire);
+            if (current == 0){
+                UInt64 expected = 0;
+                if (slot.m_key.compare_exchange_strong(expected, k, std::memory_order_acq_rel) || expected == k){
+                    return &slot;
+                }
+
+                continue;
+            }
+
+            if (current == k){
+                return &slot;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static void record(DataGroup dg, Dat dat, Msg msg, ReturnCode rc, UInt64 ns) noexcept{
+        auto slot = find(key(dg, dat, msg));
+        if (!slot){
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        slot->m_calls.fetch_add(1, std::memory_order_relaxed);
+        if (rc == ReturnCode::Failure){
+            slot->m_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        slot->m_totalNs.fetch_add(ns, std::memory_order_relaxed);
+        slot->m_buckets[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+        auto max = slot->m_maxNs.load(std::memory_order_relaxed);
+        while (ns > max && !slot->m_maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)){}
+    }
+
+    /// Fills the request, optionally resets the counters.
+    /// Only triplets copied into the request are reset, the rest keep counting
+    /// and are returned by the next request with enough capacity.
+    /// Counters of calls in progress may be reset only partially.
+    static void snapshot(TripletStats& stats, bool reset) noexcept{
+        stats.m_size = 0;
+        stats.m_available = 0;
+        for (auto& slot : slots){
+            auto k = slot.m_key.load(std::memory_order_acquire);
+            if (k == 0 || slot.m_calls.load(std::memory_order_relaxed) == 0){
+                continue;
+            }
+
+            stats.m_available++;
+            if (stats.m_size >= stats.m_capacity){
+                continue;
+            }
+
+            auto& entry = stats.m_entries[stats.m_size++];
+            entry.m_dg = static_cast<DataGroup>((k >> 32) & 0x7FFFFFFF);
+            entry.m_dat = static_cast<Dat>((k >> 16) & 0xFFFF);
+            entry.m_msg = static_cast<Msg>(k & 0xFFFF);
+            entry.m_calls = load(slot.m_calls, reset);
+            entry.m_failures = load(slot.m_failures, reset);
+            entry.m_totalNs = load(slot.m_totalNs, reset);
+            entry.m_maxNs = load(slot.m_maxNs, reset);
+            for (UInt32 i = 0; i < TripletStats::bucketCount; i++){
+                entry.m_buckets[i] = load(slot.m_buckets[i], reset);
+            }
+        }
+
+        // dropped calls belong to no triplet, reset them only with a complete snapshot
+        stats.m_dropped = load(dropped, reset && stats.m_available <= stats.m_capacity);
+    }
+
+    template<typename T>
+    static T load(std::atomic<T>& value, bool reset) noexcept{
+        return reset ? value.exchange(0, std::memory_order_relaxed) : value.load(std::memory_order_relaxed);
+    }
+
+};
+
+template<typename Dummy>
+typename TripletStatsData<Dummy>::Slot TripletStatsData<Dummy>::slots[TripletStatsData<Dummy>::slotCount];
+
+template<typename Dummy>
+std::atomic<UInt64> TripletStatsData<Dummy>::dropped(0);
+
+}
+#endif
+
+}
+
+#endif // TWPP_DETAIL_FILE_TRIPLETSTATS_HPP
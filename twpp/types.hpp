@@ -36,9 +36,11 @@ typedef std::uintptr_t UIntPtr;
 typedef std::uint8_t UInt8;
 typedef std::uint16_t UInt16;
 typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
 typedef std::int8_t Int8;
 typedef std::int16_t Int16;
 typedef std::int32_t Int32;
+typedef std::int64_t Int64;
 
 /// Boolean value.
 /// Implemented as a class to provide better type safety.